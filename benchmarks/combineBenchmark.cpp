@@ -0,0 +1,97 @@
+//
+// Benchmark: hashed combining passes vs. the pairwise group scan on dense random functions. The
+// group scan runs once per combine kernel version the CPU has (scalar up to its best SIMD level).
+//
+// Build from the repo root (main.cpp is left out, this file has its own main):
+//   g++ -std=c++17 -O2 -IcodeLibrary -o combineBenchmark benchmarks/combineBenchmark.cpp
+//       codeLibrary/Implicant.cpp codeLibrary/FileManip.cpp codeLibrary/PItable.cpp codeLibrary/VerliogConverter.cpp
+//       codeLibrary/ThreadPool.cpp codeLibrary/CoverSolver.cpp codeLibrary/PIChart.cpp codeLibrary/Espresso.cpp codeLibrary/MappedFile.cpp
+//       codeLibrary/ResultCache.cpp codeLibrary/Npn.cpp codeLibrary/Profile.cpp codeLibrary/Zdd.cpp codeLibrary/Verifier.cpp
+//       codeLibrary/CombineKernel.cpp codeLibrary/CubeIndex.cpp -pthread
+// Usage: ./combineBenchmark [maxVars] [seed]
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+
+#include "Implicant.h"
+
+namespace {
+
+// dense random function: ~50% of the points are minterms and ~10% are don't-cares
+void makeDenseFunction(int n, unsigned seed, vector<Term>& minterms, vector<Term>& dontCares) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, 99);
+    minterms.clear();
+    dontCares.clear();
+    for (int t = 0; t < (1 << n); ++t) {
+        int r = pick(rng);
+        if (r < 50) minterms.push_back(t);
+        else if (r < 60) dontCares.push_back(t);
+    }
+}
+
+vector<Cube> sortedCubes(const vector<Implicant>& primes) {
+    vector<Cube> cubes;
+    for (const auto& p : primes) cubes.push_back(p.cube);
+    sort(cubes.begin(), cubes.end(), [](const Cube& a, const Cube& b) {
+        return a.mask != b.mask ? a.mask < b.mask : a.value < b.value;
+    });
+    return cubes;
+}
+
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int maxVars = (argc > 1) ? atoi(argv[1]) : 14;
+    unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1u;
+
+    const SimdLevel best = CombineKernel::detect();
+    cout << "combine kernel: " << CombineKernel::name(best) << "\n";
+    cout << " n   terms   primes";
+    for (int l = 0; l <= (int)best; ++l) {
+        const string column = string(" scan/") + CombineKernel::name((SimdLevel)l) + "(ms)";
+        cout << setw(18) << column;
+    }
+    cout << "   hashProbe(ms)   speedup\n";
+    for (int n = 8; n <= maxVars; n += 2) {
+        vector<Term> minterms, dontCares;
+        makeDenseFunction(n, seed + (unsigned)n, minterms, dontCares);
+        vector<Implicant> initial = Implicant::buildInitialImplicants(n, minterms, dontCares);
+
+        vector<Implicant> hashPrimes;
+        double hashMs = timeMs([&] { hashPrimes = Implicant::generatePrimeImplicants(initial, n); });
+        const vector<Cube> expected = sortedCubes(hashPrimes);
+
+        vector<double> scanMs;
+        for (int l = 0; l <= (int)best; ++l) {
+            vector<Implicant> scanPrimes;
+            scanMs.push_back(timeMs([&] {
+                scanPrimes = Implicant::generatePrimeImplicantsGroupScan(initial, n, (SimdLevel)l);
+            }));
+            if (sortedCubes(scanPrimes) != expected) {
+                cerr << "Error: prime sets differ for n=" << n << " (" << CombineKernel::name((SimdLevel)l) << ")\n";
+                return 1;
+            }
+        }
+
+        cout << setw(2) << n << setw(8) << (minterms.size() + dontCares.size())
+             << setw(9) << hashPrimes.size()
+             << fixed << setprecision(2);
+        for (double ms : scanMs) cout << setw(18) << ms;
+        // against the fastest scan
+        cout << setw(16) << hashMs
+             << setw(10) << (hashMs > 0 ? scanMs.back() / hashMs : 0.0) << "x\n";
+    }
+    return 0;
+}
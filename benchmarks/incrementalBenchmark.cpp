@@ -0,0 +1,98 @@
+//
+// Benchmark: one-point edits with IncrementalMinimizer vs. running the whole exact pipeline again
+// on every variant (the result sizes are cross-checked after each edit).
+//
+// Build from the repo root (main.cpp is left out, this file has its own main):
+//   g++ -std=c++17 -O2 -IcodeLibrary -o incrementalBenchmark benchmarks/incrementalBenchmark.cpp
+//       codeLibrary/IncrementalMinimizer.cpp codeLibrary/Implicant.cpp codeLibrary/FileManip.cpp codeLibrary/PItable.cpp
+//       codeLibrary/VerliogConverter.cpp codeLibrary/ThreadPool.cpp codeLibrary/CoverSolver.cpp codeLibrary/PIChart.cpp
+//       codeLibrary/Espresso.cpp codeLibrary/MappedFile.cpp codeLibrary/ResultCache.cpp codeLibrary/Npn.cpp
+//       codeLibrary/Profile.cpp codeLibrary/Zdd.cpp codeLibrary/Verifier.cpp codeLibrary/CombineKernel.cpp
+//       codeLibrary/CubeIndex.cpp -pthread
+// Usage: ./incrementalBenchmark [edits] [seed]
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+
+#include "IncrementalMinimizer.h"
+#include "PIChart.h"
+#include "PItable.h"
+
+namespace {
+
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// the pipeline a full re-run goes through (doQMmin without the printing), one minimum cover
+size_t fullRun(int n, const vector<Term>& minterms, const vector<Term>& dontCares) {
+    vector<Implicant> primes = Implicant::generatePrimeImplicants(Implicant::buildInitialImplicants(n, minterms, dontCares), n);
+    if (minterms.empty()) return 0;
+    PIChart chart = PIChart::build(primes, minterms);
+    vector<int> essential = Implicant::findEssentialPIs(chart);
+    vector<int> remaining = chart.uncoveredColumns(essential);
+    vector<ProductTerm> solutions = PItable::solvePIMatrixAndMinimize(primes, chart, essential, remaining,
+                                                                      CoverMode::BranchAndBound, true, 1);
+    return essential.size() + (solutions.empty() ? 0 : solutions[0].size());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int edits = (argc > 1) ? std::max(atoi(argv[1]), 1) : 100;
+    unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1u;
+
+    cout << " n   minterms   primes   full(ms/edit)   incremental(ms/edit)   speedup   columns solved/edit\n";
+    for (int n = 10; n <= 16; n += 2) {
+        // sparser as n grows, so the full run stays within reach of the exact cover solver
+        const int onPercent = 160 / n;
+        std::mt19937_64 rng(seed + (unsigned)n);
+        BooleanFunction function;
+        function.nbVars = n;
+        function.minterms.assign(1, {});
+        function.dontCares.assign(1, {});
+        for (Term t = 0; t < (1ULL << n); ++t) {
+            int r = (int)(rng() % 100);
+            if (r < onPercent) function.minterms[0].push_back(t);
+            else if (r < onPercent + 2) function.dontCares[0].push_back(t);
+        }
+
+        IncrementalMinimizer minimizer(function);
+        double fullMs = 0, incrementalMs = 0;
+        size_t columnsSolved = 0;
+        for (int e = 0; e < edits; ++e) {
+            // mostly points that join or leave the on-set, some don't cares
+            const Term term = rng() & Cube::fullMask(n);
+            const int op = (int)(rng() % 5);
+            incrementalMs += timeMs([&] {
+                if (op < 2) minimizer.addMinterm(term);
+                else if (op < 4) minimizer.removeMinterm(term);
+                else minimizer.setDontCare(term);
+            });
+            columnsSolved += minimizer.lastEdit().columnsSolved;
+            size_t expected = 0;
+            const vector<Term> minterms = minimizer.minterms();
+            const vector<Term> dontCares = minimizer.dontCares();
+            fullMs += timeMs([&] { expected = fullRun(n, minterms, dontCares); });
+            if (minimizer.cover().size() != expected) {
+                cerr << "Error: n=" << n << " edit " << e << ": " << minimizer.cover().size()
+                     << " cubes instead of " << expected << "\n";
+                return 1;
+            }
+        }
+
+        cout << setw(2) << n << setw(11) << minimizer.minterms().size() << setw(9) << minimizer.primes().size()
+             << fixed << setprecision(3)
+             << setw(16) << fullMs / edits << setw(23) << incrementalMs / edits
+             << setw(9) << setprecision(1) << (incrementalMs > 0 ? fullMs / incrementalMs : 0.0) << "x"
+             << setw(22) << (double)columnsSolved / edits << "\n";
+    }
+    return 0;
+}
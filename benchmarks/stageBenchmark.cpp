@@ -0,0 +1,421 @@
+//
+// Benchmark: time of every stage of the exact pipeline (and of the heuristic engine) on seeded
+// random functions, reported as JSON so runs can be compared across versions.
+//
+// Build from the repo root (main.cpp is left out, this file has its own main):
+//   g++ -std=c++17 -O2 -IcodeLibrary -o stageBenchmark benchmarks/stageBenchmark.cpp
+//       codeLibrary/Implicant.cpp codeLibrary/FileManip.cpp codeLibrary/PItable.cpp codeLibrary/VerliogConverter.cpp
+//       codeLibrary/ThreadPool.cpp codeLibrary/CoverSolver.cpp codeLibrary/PIChart.cpp codeLibrary/Espresso.cpp
+//       codeLibrary/MappedFile.cpp codeLibrary/ResultCache.cpp codeLibrary/Npn.cpp codeLibrary/Profile.cpp codeLibrary/Zdd.cpp
+//       codeLibrary/Verifier.cpp codeLibrary/CombineKernel.cpp codeLibrary/CubeIndex.cpp -pthread
+// Usage: ./stageBenchmark [--seed S] [--reps R] [--threads T] [--out FILE] [--alloc-time]
+//                         [--n N [--on P] [--dc P] [--cyclic K] [--terms T]]
+// Without --n a fixed suite runs (random 8-16 variables, cyclic cores, sparse 32/48 variables).
+// --on / --dc are percentages of the points; past 20 variables the points aren't enumerated and
+// --terms random terms are drawn instead (split between on-set and don't cares by --on : --dc).
+// --cyclic K plants K cyclic cores (no essential PI, two minimum covers each) on top.
+// Every stage also reports its heap traffic (operator new calls, bytes, high-water mark of live
+// bytes) and the run its peak RSS; --alloc-time adds the time spent inside operator new / delete.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <random>
+#include <sys/resource.h>
+
+#include "FileManip.h"
+#include "PIChart.h"
+#include "PItable.h"
+#include "ThreadPool.h"
+#include "Verifier.h"
+
+namespace {
+
+// Heap accounting. Every allocation carries a small header with its size, so delete knows how
+// many live bytes go away. Timing (two clock reads per call) is off unless --alloc-time, it
+// slows the stages down noticeably.
+const size_t kHeapHeader = 16; // keeps the alignment of malloc
+
+struct HeapCounters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> live{0};
+    std::atomic<uint64_t> peak{0};
+    std::atomic<uint64_t> nanos{0};
+    std::atomic<bool> timed{false};
+};
+
+HeapCounters& heap() {
+    static HeapCounters counters;
+    return counters;
+}
+
+uint64_t nowNanos() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void* countedAlloc(size_t size) {
+    HeapCounters& counters = heap();
+    const bool timed = counters.timed.load(std::memory_order_relaxed);
+    const uint64_t start = timed ? nowNanos() : 0;
+    char* block = (char*)std::malloc(size + kHeapHeader);
+    if (timed) counters.nanos.fetch_add(nowNanos() - start, std::memory_order_relaxed);
+    if (block == nullptr) throw std::bad_alloc();
+    *(size_t*)block = size;
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    uint64_t live = counters.live.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = counters.peak.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return block + kHeapHeader;
+}
+
+void countedFree(void* pointer) {
+    if (pointer == nullptr) return;
+    HeapCounters& counters = heap();
+    char* block = (char*)pointer - kHeapHeader;
+    counters.live.fetch_sub(*(size_t*)block, std::memory_order_relaxed);
+    const bool timed = counters.timed.load(std::memory_order_relaxed);
+    const uint64_t start = timed ? nowNanos() : 0;
+    std::free(block);
+    if (timed) counters.nanos.fetch_add(nowNanos() - start, std::memory_order_relaxed);
+}
+
+// ru_maxrss is in kilobytes on Linux and in bytes on macOS
+uint64_t peakRssKB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss / 1024;
+#else
+    return (uint64_t)usage.ru_maxrss;
+#endif
+}
+
+// past this many variables the generator samples terms instead of visiting every point
+const int kMaxEnumeratedVars = 20;
+
+struct FunctionSpec {
+    int n = 10;
+    int onPercent = 50;
+    int dcPercent = 10;
+    int cyclicCores = 0;
+    size_t sampledTerms = 20000;
+};
+
+// Cyclic core: the 3-variable function m(0,1,2,5,6,7) (six PIs in a ring, no essential one)
+// on the low 3 variables, one copy per prefix of the other variables. The prefixes have even
+// parity, so two copies differ in at least 2 prefix bits and never combine with each other;
+// the random terms only go to odd prefixes.
+BooleanFunction makeFunction(const FunctionSpec& spec, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    BooleanFunction function;
+    function.nbVars = spec.n;
+    function.minterms.assign(1, {});
+    function.dontCares.assign(1, {});
+    vector<Term>& minterms = function.minterms[0];
+    vector<Term>& dontCares = function.dontCares[0];
+
+    const int prefixBits = spec.n - 3;
+    auto evenPrefix = [](Term t) { return (popcount64(t >> 3) & 1) == 0; };
+    std::unordered_set<Term> corePrefixes;
+    if (spec.cyclicCores > 0 && prefixBits >= 1) {
+        const Term prefixes = (prefixBits >= 63) ? ~0ULL : (1ULL << prefixBits);
+        const size_t wanted = std::min<size_t>((size_t)spec.cyclicCores, (size_t)std::max<Term>(prefixes / 2, 1));
+        while (corePrefixes.size() < wanted) {
+            Term prefix = rng() & (prefixes - 1);
+            if (popcount64(prefix) & 1) prefix ^= 1; // even parity
+            corePrefixes.insert(prefix);
+        }
+        for (Term prefix : corePrefixes)
+            for (Term low : {0, 1, 2, 5, 6, 7}) minterms.push_back((prefix << 3) | low);
+    }
+    auto randomAllowed = [&](Term t) { return corePrefixes.empty() || !evenPrefix(t); };
+
+    std::uniform_int_distribution<int> percent(0, 99);
+    if (spec.n <= kMaxEnumeratedVars) {
+        for (Term t = 0; t < (1ULL << spec.n); ++t) {
+            if (!randomAllowed(t)) continue;
+            int r = percent(rng);
+            if (r < spec.onPercent) minterms.push_back(t);
+            else if (r < spec.onPercent + spec.dcPercent) dontCares.push_back(t);
+        }
+    } else {
+        std::unordered_set<Term> seen(minterms.begin(), minterms.end());
+        const int total = std::max(spec.onPercent + spec.dcPercent, 1);
+        const size_t target = seen.size() + spec.sampledTerms;
+        while (seen.size() < target) {
+            Term t = rng() & Cube::fullMask(spec.n);
+            if (!randomAllowed(t) || !seen.insert(t).second) continue;
+            if ((int)(rng() % (uint64_t)total) < spec.onPercent) minterms.push_back(t);
+            else dontCares.push_back(t);
+        }
+    }
+    sort(minterms.begin(), minterms.end());
+    sort(dontCares.begin(), dontCares.end());
+    return function;
+}
+
+string termLine(char prefix, const vector<Term>& terms) {
+    std::ostringstream line;
+    line << prefix;
+    for (size_t i = 0; i < terms.size(); ++i) line << (i ? ", " : "") << terms[i];
+    return line.str();
+}
+
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// min and median over the repetitions; the heap numbers are from the last repetition
+struct StageTimes {
+    vector<double> samples;
+    vector<double> allocSamples;
+    uint64_t allocCalls = 0;
+    uint64_t allocBytes = 0;
+    uint64_t peakHeapBytes = 0; // live bytes at the high-water mark, above those live at the start
+
+    double minimum() const { return *std::min_element(samples.begin(), samples.end()); }
+    double median() const {
+        vector<double> sorted = samples;
+        sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+    double allocMedian() const {
+        vector<double> sorted = allocSamples;
+        sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+};
+
+// one repetition of a stage: its time and its heap traffic
+template <typename F>
+void measure(StageTimes& stage, F&& f) {
+    HeapCounters& counters = heap();
+    const uint64_t calls = counters.calls.load();
+    const uint64_t bytes = counters.bytes.load();
+    const uint64_t nanos = counters.nanos.load();
+    const uint64_t live = counters.live.load();
+    counters.peak.store(live);
+    stage.samples.push_back(timeMs(f));
+    stage.allocCalls = counters.calls.load() - calls;
+    stage.allocBytes = counters.bytes.load() - bytes;
+    stage.peakHeapBytes = counters.peak.load() - live;
+    stage.allocSamples.push_back((double)(counters.nanos.load() - nanos) / 1e6);
+}
+
+const char* kStages[] = {"parseTerms", "buildInitialImplicants", "generatePrimeImplicants", "buildChart",
+                         "findEssentialPIs", "solvePIMatrixAndMinimize", "verify", "verilogEmission", "espresso"};
+const size_t kStageCount = sizeof(kStages) / sizeof(kStages[0]);
+
+struct CaseResult {
+    FunctionSpec spec;
+    size_t minterms = 0;
+    size_t dontCares = 0;
+    size_t primes = 0;
+    size_t essential = 0;
+    size_t columns = 0;
+    size_t remaining = 0;
+    size_t solutions = 0;
+    size_t exactCubes = 0;
+    size_t heuristicCubes = 0;
+    uint64_t peakRssKB = 0; // of the process so far (it never goes down)
+    StageTimes stages[kStageCount];
+};
+
+bool runCase(const FunctionSpec& spec, unsigned seed, int reps, ThreadPool* pool, CaseResult& result) {
+    const BooleanFunction function = makeFunction(spec, seed);
+    const int n = spec.n;
+    const vector<Term>& minterms = function.minterms[0];
+    const vector<Term>& dontCares = function.dontCares[0];
+    result.spec = spec;
+    result.minterms = minterms.size();
+    result.dontCares = dontCares.size();
+    const string mintermLine = termLine('m', minterms);
+    const string dontCareLine = termLine('d', dontCares);
+
+    for (int rep = 0; rep < reps; ++rep) {
+        vector<Term> parsedMinterms, parsedDontCares;
+        string error;
+        bool parsed = true;
+        measure(result.stages[0], [&] {
+            parsed = FileManip::parseTerms(mintermLine, 'm', Cube::fullMask(n), parsedMinterms, error) &&
+                     FileManip::parseTerms(dontCareLine, 'd', Cube::fullMask(n), parsedDontCares, error);
+        });
+        if (!parsed || parsedMinterms != minterms) {
+            cerr << "Error: the generated function doesn't parse back: " << error << "\n";
+            return false;
+        }
+
+        vector<Implicant> initial, primes;
+        measure(result.stages[1], [&] { initial = Implicant::buildInitialImplicants(n, minterms, dontCares); });
+        measure(result.stages[2], [&] { primes = Implicant::generatePrimeImplicants(initial, n, pool); });
+        PIChart chart;
+        measure(result.stages[3], [&] { chart = PIChart::build(primes, minterms); });
+        vector<int> essential;
+        measure(result.stages[4], [&] { essential = Implicant::findEssentialPIs(chart); });
+        vector<int> remaining = chart.uncoveredColumns(essential);
+        vector<ProductTerm> solutions;
+        // reduced first, as this stage has always been timed (listing every cover of an
+        // unreduced random chart runs into the solver's search budget)
+        measure(result.stages[5], [&] {
+            solutions = PItable::solvePIMatrixAndMinimize(primes, chart, essential, remaining,
+                                                          CoverMode::BranchAndBound, true);
+        });
+        // the check every result goes through before it is printed
+        MinimizationResult minimized;
+        minimized.primes = primes;
+        minimized.essential = essential;
+        minimized.solutions = solutions;
+        bool verified = false;
+        measure(result.stages[6], [&] { verified = Verifier::checkResult(function, minimized, error); });
+        if (!verified) {
+            cerr << error << "\n";
+            return false;
+        }
+        // the module text without the file: SOP strings and their Verilog expressions
+        size_t verilogBytes = 0;
+        measure(result.stages[7], [&] {
+            for (const string& sop : FileManip::solutionStrings(primes, essential, solutions, n))
+                verilogBytes += VerilogConverter::convertToVerilogSyntax(sop).size();
+        });
+        Cover cover;
+        measure(result.stages[8], [&] { cover = Espresso::minimize(n, minterms, dontCares); });
+
+        result.primes = primes.size();
+        result.essential = essential.size();
+        result.columns = chart.columnCount;
+        result.remaining = remaining.size();
+        result.solutions = solutions.size();
+        result.exactCubes = essential.size() + (solutions.empty() ? 0 : solutions[0].size());
+        result.heuristicCubes = cover.size();
+    }
+    result.peakRssKB = peakRssKB();
+    return true;
+}
+
+void writeJson(std::ostream& out, unsigned seed, int reps, int threads, bool allocTime, const vector<CaseResult>& cases) {
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"benchmark\": \"stages\",\n  \"seed\": " << seed << ",\n  \"reps\": " << reps
+        << ",\n  \"threads\": " << threads << ",\n  \"allocTime\": " << (allocTime ? "true" : "false")
+        << ",\n  \"peakRssKB\": " << peakRssKB() << ",\n  \"cases\": [\n";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const CaseResult& c = cases[i];
+        out << "    {\"n\": " << c.spec.n << ", \"onPercent\": " << c.spec.onPercent
+            << ", \"dcPercent\": " << c.spec.dcPercent << ", \"cyclicCores\": " << c.spec.cyclicCores
+            << ", \"minterms\": " << c.minterms << ", \"dontCares\": " << c.dontCares
+            << ", \"primes\": " << c.primes << ", \"essential\": " << c.essential
+            << ", \"chartColumns\": " << c.columns << ", \"remainingColumns\": " << c.remaining
+            << ", \"solutions\": " << c.solutions << ", \"exactCubes\": " << c.exactCubes
+            << ", \"heuristicCubes\": " << c.heuristicCubes << ", \"peakRssKB\": " << c.peakRssKB
+            << ",\n     \"stagesMs\": {";
+        for (size_t s = 0; s < kStageCount; ++s) {
+            out << (s ? ", " : "") << "\"" << kStages[s] << "\": {\"min\": " << c.stages[s].minimum()
+                << ", \"median\": " << c.stages[s].median() << "}";
+        }
+        out << "},\n     \"heap\": {";
+        for (size_t s = 0; s < kStageCount; ++s) {
+            const StageTimes& stage = c.stages[s];
+            out << (s ? ",\n              " : "") << "\"" << kStages[s] << "\": {\"allocations\": " << stage.allocCalls
+                << ", \"bytes\": " << stage.allocBytes << ", \"peakBytes\": " << stage.peakHeapBytes;
+            if (allocTime) out << ", \"allocatorMs\": " << stage.allocMedian();
+            out << "}";
+        }
+        out << "}}" << (i + 1 < cases.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned seed = 1;
+    int reps = 5;
+    int threads = 1; // one thread by default, so the numbers don't depend on the machine's load
+    string outPath;
+    bool allocTime = false;
+    FunctionSpec single;
+    bool singleCase = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--alloc-time") {
+            allocTime = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Error: " << arg << " needs a value.\n";
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--seed") seed = (unsigned)atoi(value);
+        else if (arg == "--reps") reps = std::max(atoi(value), 1);
+        else if (arg == "--threads") threads = std::max(atoi(value), 0);
+        else if (arg == "--out") outPath = value;
+        else if (arg == "--n") { single.n = atoi(value); singleCase = true; }
+        else if (arg == "--on") single.onPercent = atoi(value);
+        else if (arg == "--dc") single.dcPercent = atoi(value);
+        else if (arg == "--cyclic") single.cyclicCores = atoi(value);
+        else if (arg == "--terms") single.sampledTerms = (size_t)atoll(value);
+        else {
+            cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    if (singleCase && (single.n < 3 || single.n > 64)) {
+        cerr << "Error: --n must be between 3 and 64.\n";
+        return 1;
+    }
+
+    vector<FunctionSpec> suite;
+    if (singleCase) {
+        suite.push_back(single);
+    } else {
+        // the on-set gets thinner as n grows: dense random charts past ~10 variables are
+        // beyond the exact cover solver (that is the heuristic's territory, see Engine::Auto)
+        suite.push_back({8, 50, 10, 0, 0});
+        suite.push_back({10, 30, 5, 0, 0});
+        suite.push_back({12, 20, 5, 0, 0});
+        suite.push_back({14, 5, 2, 0, 0});
+        suite.push_back({16, 2, 1, 0, 0});
+        suite.push_back({10, 5, 0, 8, 0});
+        suite.push_back({12, 2, 0, 16, 0});
+        suite.push_back({32, 80, 20, 0, 1000});
+        suite.push_back({48, 80, 20, 0, 2000});
+    }
+
+    heap().timed = allocTime;
+    ThreadPool pool(threads);
+    vector<CaseResult> results;
+    for (size_t i = 0; i < suite.size(); ++i) {
+        CaseResult result;
+        cerr << "case " << i + 1 << "/" << suite.size() << ": n=" << suite[i].n << "\n";
+        if (!runCase(suite[i], seed + (unsigned)i, reps, &pool, result)) return 1;
+        results.push_back(std::move(result));
+    }
+
+    if (outPath.empty()) {
+        writeJson(cout, seed, reps, pool.size(), allocTime, results);
+    } else {
+        ofstream out(outPath);
+        if (!out.is_open()) {
+            cerr << "Error: could not write " << outPath << "\n";
+            return 1;
+        }
+        writeJson(out, seed, reps, pool.size(), allocTime, results);
+    }
+    return 0;
+}
+
+// every plain new / delete of the process goes through the counters (new[] and delete[] call these)
+void* operator new(size_t size) { return countedAlloc(size); }
+void operator delete(void* pointer) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { countedFree(pointer); }
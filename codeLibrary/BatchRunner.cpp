@@ -0,0 +1,207 @@
+//
+// Non-interactive front end: minimizes many function files on the thread pool.
+//
+
+#include "BatchRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <set>
+
+#include "Npn.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// what the summary needs to know about one input
+struct FileReport {
+    std::string path;
+    std::string outputName;
+    bool ok = false;
+    std::string error;
+    int nbVars = 0;
+    size_t terms = 0;       // minterms + don't cares
+    bool heuristic = false;
+    bool cached = false;
+    size_t solutions = 0;
+    size_t cubes = 0;       // of the first solution (distinct ones, with several outputs)
+    size_t literals = 0;
+    double loadMs = 0.0;
+    double minimizeMs = 0.0;
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::vector<std::string> BatchRunner::collectInputs(const std::string& input, std::string& error) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths;
+    if (fs::is_directory(input)) {
+        for (const auto& entry : fs::directory_iterator(input))
+            if (entry.is_regular_file() && entry.path().extension() == ".txt")
+                paths.push_back(entry.path().string());
+        sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    ifstream list(input);
+    if (!list.is_open()) {
+        error = "Error: " + input + " is neither a directory nor a readable list file.";
+        return paths;
+    }
+    string line;
+    while (getline(list, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#') continue;
+        size_t last = line.find_last_not_of(" \t\r");
+        paths.push_back(line.substr(first, last - first + 1));
+    }
+    return paths;
+}
+
+int BatchRunner::run(const std::string& input, const std::string& outputDir, const RunOptions& options) {
+    namespace fs = std::filesystem;
+    const auto batchStart = std::chrono::steady_clock::now();
+
+    string error;
+    vector<string> paths = collectInputs(input, error);
+    if (!error.empty()) {
+        cerr << error << endl;
+        return 1;
+    }
+    if (paths.empty()) {
+        cerr << "Error: no function files found in " << input << endl;
+        return 1;
+    }
+    std::error_code ec;
+    fs::create_directories(outputDir, ec);
+    if (ec) {
+        cerr << "Error: could not create " << outputDir << ": " << ec.message() << endl;
+        return 1;
+    }
+
+    // output names from the file names; a repeated name gets _2, _3, ...
+    vector<FileReport> reports(paths.size());
+    std::map<string, int> nameCount;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        reports[i].path = paths[i];
+        string stem = fs::path(paths[i]).stem().string();
+        int count = ++nameCount[stem];
+        reports[i].outputName = (count == 1) ? stem : stem + "_" + to_string(count);
+    }
+
+    // one task per file. With at least as many files as threads the files alone keep the pool
+    // busy, so each file runs single-threaded (which also keeps its timing its own); with fewer
+    // files the combining passes inside each run use the pool too.
+    ThreadPool pool(options.threads);
+    ThreadPool* innerPool = (paths.size() >= (size_t)pool.size()) ? nullptr : &pool;
+    auto minimizeFile = [&](FileReport& report) {
+        auto start = std::chrono::steady_clock::now();
+        BooleanFunction function;
+        bool loaded = FileManip::loadFunction(report.path, function, report.error);
+        report.loadMs = millisecondsSince(start);
+        if (!loaded) return;
+        report.nbVars = function.nbVars;
+        for (size_t o = 0; o < function.outputCount(); ++o)
+            report.terms += function.minterms[o].size() + function.dontCares[o].size();
+
+        start = std::chrono::steady_clock::now();
+        MinimizationResult result = FileManip::minimize(function, options, innerPool, false);
+        report.minimizeMs = millisecondsSince(start);
+        report.heuristic = result.heuristic;
+        report.cached = result.fromCache;
+        if (!result.verifyError.empty()) {
+            report.error = result.verifyError;
+            return;
+        }
+
+        if (result.outputCount > 1) {
+            report.solutions = result.outputSelections.size();
+            std::set<int> used;
+            for (const vector<int>& terms : result.outputSelections[0]) used.insert(terms.begin(), terms.end());
+            report.cubes = used.size();
+            for (int idx : used) report.literals += (size_t)result.primes[idx].cube.literalCount();
+        } else {
+            // as many as resultText prints (only EPIs make one solution), without formatting them twice
+            report.solutions = std::max(result.solutions.size(), result.essential.empty() ? (size_t)0 : (size_t)1);
+        }
+        if (result.outputCount == 1 && report.solutions != 0) {
+            vector<int> first = result.essential;
+            if (!result.solutions.empty()) first.insert(first.end(), result.solutions[0].begin(), result.solutions[0].end());
+            report.cubes = first.size();
+            for (int idx : first) report.literals += (size_t)result.primes[idx].cube.literalCount();
+        }
+
+        ofstream out(outputDir + "/" + report.outputName + ".out");
+        if (!out.is_open()) {
+            report.error = "Error: could not write " + report.outputName + ".out";
+            return;
+        }
+        out << "# " << report.path << "\n";
+        if (result.outputCount > 1) {
+            out << "# variables: " << function.nbVars << ", outputs: " << result.outputCount << "\n";
+            for (size_t o = 0; o < result.outputCount; ++o)
+                out << "# F" << o << " minterms: " << function.minterms[o].size()
+                    << ", don't cares: " << function.dontCares[o].size() << "\n";
+        } else {
+            out << "# variables: " << function.nbVars << ", minterms: " << function.minterms[0].size()
+                << ", don't cares: " << function.dontCares[0].size() << "\n";
+        }
+        string npnClass = Npn::classOf(function);
+        if (!npnClass.empty()) out << "# npn class: " << npnClass << "\n";
+        out << "# engine: " << (result.heuristic ? "heuristic" : "exact") << "\n";
+        out << FileManip::resultText(result, function.nbVars);
+        report.ok = true;
+    };
+    pool.run(paths.size(), [&](size_t i) {
+        // running out of memory, or anything else thrown, fails that file only
+        try {
+            minimizeFile(reports[i]);
+        } catch (const std::bad_alloc&) {
+            reports[i].ok = false;
+            reports[i].error = "Error: out of memory";
+        } catch (const std::exception& e) {
+            reports[i].ok = false;
+            reports[i].error = std::string("Error: ") + e.what();
+        }
+    });
+
+    // summary, in input order
+    std::ostringstream summary;
+    summary << left << setw(28) << "file" << right << setw(5) << "vars" << setw(8) << "terms"
+            << setw(11) << "engine" << setw(10) << "solutions" << setw(7) << "cubes" << setw(10) << "literals"
+            << setw(11) << "load(ms)" << setw(14) << "minimize(ms)" << "  status\n";
+    size_t failed = 0;
+    double totalMinimize = 0.0;
+    for (const FileReport& report : reports) {
+        summary << left << setw(28) << report.outputName << right;
+        if (!report.ok) {
+            ++failed;
+            summary << setw(5) << "-" << setw(8) << "-" << setw(11) << "-" << setw(10) << "-" << setw(7) << "-"
+                    << setw(10) << "-" << setw(11) << fixed << setprecision(2) << report.loadMs
+                    << setw(14) << report.minimizeMs << "  " << report.error << "\n";
+            continue;
+        }
+        totalMinimize += report.minimizeMs;
+        summary << setw(5) << report.nbVars << setw(8) << report.terms
+                << setw(11) << (report.heuristic ? "heuristic" : "exact") << setw(10) << report.solutions
+                << setw(7) << report.cubes << setw(10) << report.literals
+                << setw(11) << fixed << setprecision(2) << report.loadMs
+                << setw(14) << report.minimizeMs << (report.cached ? "  ok (cached)\n" : "  ok\n");
+    }
+    summary << "\n" << reports.size() << " file(s), " << failed << " failed, "
+            << fixed << setprecision(2) << totalMinimize << " ms minimizing, "
+            << millisecondsSince(batchStart) << " ms wall time on " << pool.size() << " thread(s)\n";
+
+    ofstream summaryFile(outputDir + "/summary.txt");
+    summaryFile << summary.str();
+    cout << summary.str();
+    return failed == 0 ? 0 : 1;
+}
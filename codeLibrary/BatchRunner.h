@@ -0,0 +1,24 @@
+//
+// Non-interactive front end: minimizes many function files on the thread pool.
+//
+
+#ifndef QM_DD1_BATCHRUNNER_H
+#define QM_DD1_BATCHRUNNER_H
+
+#include <string>
+#include <vector>
+
+#include "FileManip.h"
+
+class BatchRunner {
+public:
+    // input is a directory (every .txt file in it) or a list file (one path per line, blank
+    // lines and lines starting with '#' skipped). Each function gets <outputDir>/<name>.out with
+    // its solutions, and <outputDir>/summary.txt lists every file with its timings (also
+    // printed). Returns 0 when every file was minimized, 1 otherwise.
+    static int run(const std::string& input, const std::string& outputDir, const RunOptions& options);
+
+    static std::vector<std::string> collectInputs(const std::string& input, std::string& error);
+};
+
+#endif //QM_DD1_BATCHRUNNER_H
@@ -0,0 +1,142 @@
+//
+// Scalar / SSE4.2 / AVX2 / AVX-512 versions of the batched combine test (see CombineKernel.h).
+//
+
+#include "CombineKernel.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QM_COMBINE_X86 1
+#endif
+
+namespace {
+
+// every version handles `count` <= 64 cubes from masks / values and returns their match bits
+uint64_t matchBlockScalar(uint64_t mask, uint64_t value, const uint64_t* masks, const uint64_t* values, size_t count) {
+    uint64_t bits = 0;
+    for (size_t j = 0; j < count; ++j) {
+        const uint64_t diff = values[j] ^ value;
+        // one bit apart: diff is a power of two
+        if (masks[j] == mask && diff && !(diff & (diff - 1))) bits |= 1ULL << j;
+    }
+    return bits;
+}
+
+// the cubes j..count-1 the vector loop left over, at their bit positions; nothing is left when
+// count is a multiple of the lanes, and a shift by j == 64 would be undefined
+inline uint64_t scalarTail(uint64_t mask, uint64_t value, const uint64_t* masks, const uint64_t* values, size_t count,
+                           size_t j) {
+    return j < count ? matchBlockScalar(mask, value, masks + j, values + j, count - j) << j : 0;
+}
+
+#ifdef QM_COMBINE_X86
+__attribute__((target("sse4.2")))
+uint64_t matchBlockSse42(uint64_t mask, uint64_t value, const uint64_t* masks, const uint64_t* values, size_t count) {
+    const __m128i m = _mm_set1_epi64x((long long)mask);
+    const __m128i v = _mm_set1_epi64x((long long)value);
+    const __m128i one = _mm_set1_epi64x(1);
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t bits = 0;
+    size_t j = 0;
+    for (; j + 2 <= count; j += 2) {
+        const __m128i diff = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(values + j)), v);
+        const __m128i sameMask = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i*)(masks + j)), m);
+        const __m128i single = _mm_cmpeq_epi64(_mm_and_si128(diff, _mm_sub_epi64(diff, one)), zero);
+        const __m128i none = _mm_cmpeq_epi64(diff, zero);
+        const __m128i ok = _mm_andnot_si128(none, _mm_and_si128(sameMask, single));
+        bits |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(ok)) << j;
+    }
+    return bits | scalarTail(mask, value, masks, values, count, j);
+}
+
+__attribute__((target("avx2")))
+uint64_t matchBlockAvx2(uint64_t mask, uint64_t value, const uint64_t* masks, const uint64_t* values, size_t count) {
+    const __m256i m = _mm256_set1_epi64x((long long)mask);
+    const __m256i v = _mm256_set1_epi64x((long long)value);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t bits = 0;
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        const __m256i diff = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(values + j)), v);
+        const __m256i sameMask = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(masks + j)), m);
+        const __m256i single = _mm256_cmpeq_epi64(_mm256_and_si256(diff, _mm256_sub_epi64(diff, one)), zero);
+        const __m256i none = _mm256_cmpeq_epi64(diff, zero);
+        const __m256i ok = _mm256_andnot_si256(none, _mm256_and_si256(sameMask, single));
+        bits |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(ok)) << j;
+    }
+    return bits | scalarTail(mask, value, masks, values, count, j);
+}
+
+__attribute__((target("avx512f")))
+uint64_t matchBlockAvx512(uint64_t mask, uint64_t value, const uint64_t* masks, const uint64_t* values, size_t count) {
+    const __m512i m = _mm512_set1_epi64((long long)mask);
+    const __m512i v = _mm512_set1_epi64((long long)value);
+    const __m512i one = _mm512_set1_epi64(1);
+    uint64_t bits = 0;
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        const __m512i diff = _mm512_xor_si512(_mm512_loadu_si512((const void*)(values + j)), v);
+        __mmask8 ok = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512((const void*)(masks + j)), m);
+        ok &= _mm512_test_epi64_mask(diff, diff);                            // diff != 0
+        ok &= _mm512_testn_epi64_mask(diff, _mm512_sub_epi64(diff, one));   // diff & (diff - 1) == 0
+        bits |= (uint64_t)ok << j;
+    }
+    return bits | scalarTail(mask, value, masks, values, count, j);
+}
+#endif
+
+using BlockKernel = uint64_t (*)(uint64_t, uint64_t, const uint64_t*, const uint64_t*, size_t);
+
+BlockKernel kernelFor(SimdLevel level) {
+#ifdef QM_COMBINE_X86
+    switch (level) {
+        case SimdLevel::Avx512: return matchBlockAvx512;
+        case SimdLevel::Avx2: return matchBlockAvx2;
+        case SimdLevel::Sse42: return matchBlockSse42;
+        case SimdLevel::Scalar: break;
+    }
+#else
+    (void)level;
+#endif
+    return matchBlockScalar;
+}
+
+} // namespace
+
+SimdLevel CombineKernel::detect() {
+#ifdef QM_COMBINE_X86
+    static const SimdLevel level = __builtin_cpu_supports("avx512f") ? SimdLevel::Avx512
+                                 : __builtin_cpu_supports("avx2") ? SimdLevel::Avx2
+                                 : __builtin_cpu_supports("sse4.2") ? SimdLevel::Sse42
+                                 : SimdLevel::Scalar;
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char* CombineKernel::name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Avx512: return "avx512";
+        case SimdLevel::Avx2: return "avx2";
+        case SimdLevel::Sse42: return "sse4.2";
+        case SimdLevel::Scalar: break;
+    }
+    return "scalar";
+}
+
+void CombineKernel::match(const Cube& cube, const CubeGroup& group, std::vector<uint64_t>& matches, SimdLevel level) {
+    // a level the CPU doesn't have would fault, so ask for at most the detected one
+    if (level > detect()) level = detect();
+    const BlockKernel kernel = kernelFor(level);
+    const size_t count = group.size();
+    matches.assign((count + 63) / 64, 0);
+    for (size_t w = 0; w < matches.size(); ++w) {
+        const size_t begin = w * 64;
+        matches[w] = kernel(cube.mask, cube.value, group.masks.data() + begin, group.values.data() + begin,
+                            std::min<size_t>(64, count - begin));
+    }
+}
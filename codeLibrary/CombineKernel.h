@@ -0,0 +1,55 @@
+//
+// Batched combine test for the group scan: one cube against a block of the next group.
+//
+
+#ifndef QM_DD1_COMBINEKERNEL_H
+#define QM_DD1_COMBINEKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Cube.h"
+
+// instruction sets the kernel has a version for, weakest first
+enum class SimdLevel {
+    Scalar,
+    Sse42,  // 2 cubes per compare
+    Avx2,   // 4
+    Avx512  // 8
+};
+
+// One group of cubes as structure of arrays, so a block of masks / values is one vector load.
+struct CubeGroup {
+    std::vector<uint64_t> masks;
+    std::vector<uint64_t> values;
+
+    size_t size() const { return masks.size(); }
+    void clear() {
+        masks.clear();
+        values.clear();
+    }
+    void push(const Cube& c) {
+        masks.push_back(c.mask);
+        values.push_back(c.value);
+    }
+};
+
+// Two cubes combine when they have the same mask and their values are one bit apart
+// (Implicant::canCombine). The kernel tests a cube of group g against every cube of group g+1
+// and returns the matches as a bitmask, with the widest version the CPU runs (picked once at
+// run time, the others stay available for benchmarks and cross-checks).
+class CombineKernel {
+public:
+    static SimdLevel detect(); // the best level this CPU has
+    static const char* name(SimdLevel level);
+
+    // bit j of matches (word j / 64) is set when `cube` combines with group cube j; matches
+    // gets (group.size() + 63) / 64 words
+    static void match(const Cube& cube, const CubeGroup& group, std::vector<uint64_t>& matches, SimdLevel level);
+    static void match(const Cube& cube, const CubeGroup& group, std::vector<uint64_t>& matches) {
+        match(cube, group, matches, detect());
+    }
+};
+
+#endif //QM_DD1_COMBINEKERNEL_H
@@ -0,0 +1,266 @@
+//
+// Exact minimum cover of the PI chart by branch and bound.
+//
+
+#include "CoverSolver.h"
+
+#include "Profile.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// search nodes allowed for listing the alternative minimum covers
+const size_t kEnumerationNodes = 100000;
+
+inline bool testBit(const std::vector<uint64_t>& bits, size_t i) {
+    return (bits[i / 64] >> (i % 64)) & 1ULL;
+}
+
+// Depth-first search over "which row covers the hardest open column". Rows tried at a node
+// are forbidden in the later siblings, so every cover is reached at most once. A minimum cover
+// is irredundant, so a branch where some chosen row no longer covers any column on its own
+// is cut right away.
+//
+// The search runs twice:
+//  1. find the minimum size. Here only sizes strictly below the best so far are interesting,
+//     so a row whose open columns are a subset of another row's can be dropped at each node.
+//     A caller that has a fallback (Engine::Auto) gives this pass a node budget too; running
+//     out of it stops the search with no result.
+//  2. enumerate every cover of that size. Dominated rows can be part of a minimum cover too,
+//     so this pass keeps them and only has the exact bound from pass 1 to prune with. Charts
+//     with a huge number of equivalent minimum covers would never finish listing them, so this
+//     pass has a node budget; when it runs out the covers found so far are returned (pass 1
+//     always provides at least one).
+struct Search {
+    const std::vector<std::vector<uint64_t>>& rows;
+    size_t columnCount;
+    size_t words;
+    std::vector<std::vector<int>> columnRows; // column -> rows covering it
+
+    std::vector<uint64_t> open;   // columns not covered by the chosen rows
+    std::vector<uint64_t> multi;  // columns covered by two or more chosen rows
+    std::vector<char> forbidden;  // row -> excluded in this subtree
+    std::vector<int> chosen;
+    std::vector<int> rowStamp;    // scratch for the lower bound
+    std::vector<double> rowLoad;
+    int stamp = 0;
+
+    bool enumerate = false;       // pass 2
+    size_t maxSolutions = 0;      // pass 2: 0 = no limit
+    bool counting = false;        // pass 2: go on past maxSolutions, only counting the covers
+    size_t extra = 0;             // pass 2: covers found past maxSolutions
+    size_t nodeBudget = 0;        // pass 2: nodes left to visit
+    size_t searchBudget = 0;      // pass 1: nodes left to visit, when limited
+    bool limited = false;         // pass 1 has a budget
+    bool gaveUp = false;          // pass 1 ran out of it
+    size_t bestSize;
+    std::vector<std::vector<int>> best;
+    QM_PROFILE_ONLY(uint64_t nodes = 0;)
+
+    Search(const std::vector<std::vector<uint64_t>>& r, size_t columns)
+        : rows(r), columnCount(columns), words((columns + 63) / 64), columnRows(columns),
+          open(words, ~0ULL), multi(words, 0), forbidden(r.size(), 0), rowStamp(r.size(), 0), rowLoad(r.size(), 0.0), bestSize(r.size() + 1) {
+        if (columns % 64) open[words - 1] = (1ULL << (columns % 64)) - 1ULL;
+        for (size_t i = 0; i < rows.size(); ++i)
+            for (size_t c = 0; c < columnCount; ++c)
+                if (testBit(rows[i], c)) columnRows[c].push_back((int)i);
+    }
+
+    int openCount(int row) const {
+        int count = 0;
+        for (size_t w = 0; w < words; ++w) count += __builtin_popcountll(rows[row][w] & open[w]);
+        return count;
+    }
+
+    // row a's open columns are a subset of row b's
+    bool openSubset(int a, int b) const {
+        for (size_t w = 0; w < words; ++w)
+            if (rows[a][w] & open[w] & ~rows[b][w]) return false;
+        return true;
+    }
+
+    // Lower bound on the rows still to pick: a feasible solution of the dual of the LP
+    // relaxation. Every open column gets a weight, taken greedily (hardest column first) as
+    // the capacity left on its rows, where each row can carry a total weight of at most 1.
+    // The sum of the weights can't exceed the size of any cover. With 0/1 weights this is
+    // the usual "independent columns need different rows" bound; fractional weights are
+    // never worse.
+    size_t dualBound(const std::vector<size_t>& columns) {
+        ++stamp;
+        double total = 0.0;
+        for (size_t c : columns) {
+            double weight = 1.0;
+            for (int r : columnRows[c]) {
+                if (forbidden[r]) continue;
+                if (rowStamp[r] != stamp) { rowStamp[r] = stamp; rowLoad[r] = 0.0; }
+                weight = std::min(weight, 1.0 - rowLoad[r]);
+            }
+            if (weight <= 0.0) continue;
+            total += weight;
+            for (int r : columnRows[c])
+                if (!forbidden[r]) rowLoad[r] += weight;
+        }
+        return (size_t)(total + 1.0 - 1e-9); // ceil with some slack for rounding
+    }
+
+    // every chosen row still covers some column no other chosen row covers
+    bool irredundant() const {
+        for (int q : chosen) {
+            bool alone = false;
+            for (size_t w = 0; w < words && !alone; ++w)
+                alone = (rows[q][w] & ~open[w] & ~multi[w]) != 0;
+            if (!alone) return false;
+        }
+        return true;
+    }
+
+    void record() {
+        if (enumerate && maxSolutions != 0 && best.size() >= maxSolutions) {
+            ++extra;
+            return;
+        }
+        if (chosen.size() < bestSize) {
+            bestSize = chosen.size();
+            best.clear();
+        }
+        std::vector<int> cover = chosen;
+        std::sort(cover.begin(), cover.end());
+        best.push_back(cover);
+    }
+
+    bool full() const {
+        if (!enumerate) return gaveUp;
+        return nodeBudget == 0 || (!counting && maxSolutions != 0 && best.size() >= maxSolutions);
+    }
+
+    // pass 1 is only after strictly smaller covers, pass 2 wants every cover of bestSize
+    bool tooBig(size_t size) const { return enumerate ? size > bestSize : size >= bestSize; }
+
+    void solve() {
+        if (full()) return;
+        if (enumerate) --nodeBudget;
+        else if (limited) {
+            if (searchBudget == 0) {
+                gaveUp = true;
+                return;
+            }
+            --searchBudget;
+        }
+        QM_PROFILE_ONLY(++nodes;)
+
+        // open columns, hardest (fewest allowed rows) first
+        std::vector<std::pair<int, size_t>> hardness;
+        for (size_t c = 0; c < columnCount; ++c) {
+            if (!testBit(open, c)) continue;
+            int allowed = 0;
+            for (int r : columnRows[c])
+                if (!forbidden[r]) ++allowed;
+            if (allowed == 0) return; // this branch can't cover c any more
+            hardness.push_back({allowed, c});
+        }
+        if (hardness.empty()) {
+            record();
+            return;
+        }
+        if (tooBig(chosen.size() + 1)) return;
+
+        std::sort(hardness.begin(), hardness.end());
+        std::vector<size_t> columns;
+        columns.reserve(hardness.size());
+        for (const auto& h : hardness) columns.push_back(h.second);
+        if (tooBig(chosen.size() + dualBound(columns))) return;
+
+        // pass 1: drop rows dominated on the open columns (ties keep the lower index)
+        std::vector<int> dominated;
+        if (!enumerate) {
+            std::vector<int> live;
+            for (size_t r = 0; r < rows.size(); ++r)
+                if (!forbidden[r] && openCount((int)r) > 0) live.push_back((int)r);
+            for (int a : live) {
+                for (int b : live) {
+                    if (a == b || forbidden[b]) continue;
+                    if (openSubset(a, b) && (!openSubset(b, a) || b < a)) {
+                        forbidden[a] = 1;
+                        dominated.push_back(a);
+                        break;
+                    }
+                }
+            }
+        }
+
+        // branch on the hardest column, trying the rows that cover the most open columns first
+        size_t column = columns.front();
+        std::vector<std::pair<int, int>> candidates; // (-gain, row)
+        for (int r : columnRows[column])
+            if (!forbidden[r]) candidates.push_back({-openCount(r), r});
+        std::sort(candidates.begin(), candidates.end());
+
+        std::vector<int> excluded;
+        for (const auto& cand : candidates) {
+            int r = cand.second;
+            std::vector<uint64_t> savedOpen = open;
+            std::vector<uint64_t> savedMulti = multi;
+            for (size_t w = 0; w < words; ++w) {
+                multi[w] |= rows[r][w] & ~open[w];
+                open[w] &= ~rows[r][w];
+            }
+            chosen.push_back(r);
+            if (irredundant()) solve();
+            chosen.pop_back();
+            open = savedOpen;
+            multi = savedMulti;
+
+            forbidden[r] = 1;
+            excluded.push_back(r);
+            if (full()) break;
+        }
+        for (int r : excluded) forbidden[r] = 0;
+        for (int r : dominated) forbidden[r] = 0;
+    }
+};
+
+} // namespace
+
+std::vector<std::vector<int>> CoverSolver::minimumCovers(const std::vector<std::vector<uint64_t>>& rows,
+                                                         size_t columnCount, size_t maxSolutions,
+                                                         bool* complete, size_t searchNodes, size_t* omitted) {
+    if (complete != nullptr) *complete = true;
+    if (omitted != nullptr) *omitted = 0;
+    if (columnCount == 0) return {{}};
+
+    QM_PROFILE_TIMER("CoverSolver::minimumCovers");
+    Search search(rows, columnCount);
+    search.limited = searchNodes != 0;
+    search.searchBudget = searchNodes;
+    search.solve();
+    QM_PROFILE_ADD("cover.searchNodes", search.nodes);
+    if (search.gaveUp) {
+        QM_PROFILE_ADD("cover.searchBudgetRunOut", 1);
+        if (complete != nullptr) *complete = false;
+        return {};
+    }
+    if (search.best.empty()) return {};
+
+    // pass 2 with the minimum size as a fixed bound
+    std::vector<std::vector<int>> found = search.best;
+    search.enumerate = true;
+    search.maxSolutions = maxSolutions;
+    search.counting = omitted != nullptr;
+    search.nodeBudget = kEnumerationNodes;
+    search.best.clear();
+    QM_PROFILE_ONLY(search.nodes = 0;)
+    search.solve();
+    QM_PROFILE_ADD("cover.enumerationNodes", search.nodes);
+
+    if (complete != nullptr && search.nodeBudget == 0) *complete = false;
+    found.insert(found.end(), search.best.begin(), search.best.end());
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    if (maxSolutions != 0 && found.size() > maxSolutions) {
+        if (omitted != nullptr) *omitted = std::max(found.size(), search.best.size() + search.extra) - maxSolutions;
+        found.resize(maxSolutions);
+    }
+    return found;
+}
@@ -0,0 +1,35 @@
+//
+// Exact minimum cover of the PI chart by branch and bound.
+//
+
+#ifndef QM_DD1_COVERSOLVER_H
+#define QM_DD1_COVERSOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// how the cyclic part of the PI chart is solved
+enum class CoverMode {
+    BranchAndBound, // CoverSolver (default)
+    Petrick,        // full product-of-sums expansion, kept as the reference
+    PetrickTree     // the same product as a balanced tree of multiplications on the thread pool (small cores only)
+};
+
+class CoverSolver {
+public:
+    // rows[i] is the bit row of candidate i over columnCount columns (bit c of word c/64).
+    // Returns the minimum-size sets of rows covering all columns (at most maxSolutions of them
+    // when it is not 0), each sorted ascending, the list sorted lexicographically. The list is
+    // complete unless the chart has so many equivalent minimum covers that listing them runs
+    // out of its search budget (then *complete is set to false); it always has at least one.
+    // Empty if some column has no row. searchNodes != 0 caps the search for the minimum size as
+    // well: past it the list is empty and *complete is false. With omitted the listing goes on
+    // past maxSolutions (same search budget) and counts the covers it leaves out there.
+    static std::vector<std::vector<int>> minimumCovers(const std::vector<std::vector<uint64_t>>& rows,
+                                                       size_t columnCount, size_t maxSolutions = 0,
+                                                       bool* complete = nullptr, size_t searchNodes = 0,
+                                                       size_t* omitted = nullptr);
+};
+
+#endif //QM_DD1_COVERSOLVER_H
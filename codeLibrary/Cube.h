@@ -0,0 +1,76 @@
+//
+// Packed cube used by the implicant tables.
+//
+
+#ifndef QM_DD1_CUBE_H
+#define QM_DD1_CUBE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// a minterm / don't-care index, up to 64 variables
+using Term = uint64_t;
+
+// popcount helper so the hot loops don't depend on C++20 <bit>
+inline int popcount64(uint64_t x) {
+    return __builtin_popcountll(x);
+}
+
+// A product term stored as two words:
+//  - mask:  bit i is set when variable i is fixed (0 or 1), cleared when it is a '-'
+//  - value: the fixed values, always 0 where mask is 0
+// Bit 0 is the least significant bit of the term, so a minterm m is simply {fullMask(n), m}
+// and the leftmost pattern character (variable A) is bit n-1.
+struct Cube {
+    uint64_t mask = 0;
+    uint64_t value = 0;
+
+    static uint64_t fullMask(int nbVars) {
+        return (nbVars >= 64) ? ~0ULL : ((1ULL << nbVars) - 1ULL);
+    }
+
+    static Cube fromTerm(uint64_t term, int nbVars) {
+        Cube c;
+        c.mask = fullMask(nbVars);
+        c.value = term & c.mask;
+        return c;
+    }
+
+    // number of 1 literals (used for grouping)
+    int countOnes() const { return popcount64(value); }
+
+    // number of literals in the product term
+    int literalCount() const { return popcount64(mask); }
+
+    bool contains(uint64_t term) const { return (term & mask) == value; }
+
+    // true if every point of other is also a point of this cube
+    bool covers(const Cube& other) const {
+        return (other.mask & mask) == mask && (other.value & mask) == value;
+    }
+
+    // string form ('0', '1', '-') only needed for printing
+    std::string toPattern(int nbVars) const {
+        std::string pattern((size_t)nbVars, '-');
+        for (int i = 0; i < nbVars; ++i) {
+            uint64_t bit = 1ULL << (nbVars - 1 - i);
+            if (mask & bit) pattern[(size_t)i] = (value & bit) ? '1' : '0';
+        }
+        return pattern;
+    }
+
+    bool operator==(const Cube& other) const { return mask == other.mask && value == other.value; }
+    bool operator!=(const Cube& other) const { return !(*this == other); }
+};
+
+struct CubeHash {
+    size_t operator()(const Cube& c) const {
+        // mix both words so cubes with the same value but different masks spread out
+        uint64_t h = c.value * 0x9E3779B97F4A7C15ULL;
+        h ^= (c.mask + 0x632BE59BD9B4E019ULL) + (h << 6) + (h >> 2);
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+#endif //QM_DD1_CUBE_H
@@ -0,0 +1,48 @@
+//
+// Containment / intersection lookups over a changing set of cubes (see CubeIndex.h).
+//
+
+#include "CubeIndex.h"
+
+CubeIndex::CubeIndex(int nbVars) : n(nbVars), nodes(1) {}
+
+void CubeIndex::insert(const Cube& cube, uint32_t id) {
+    uint32_t at = 0;
+    auto enter = [&](Node& node) {
+        ++node.count;
+        node.allOnes &= cube.value;
+        node.allZeros &= cube.mask & ~cube.value;
+        node.anyFixed |= cube.mask;
+    };
+    enter(nodes[0]);
+    for (int level = 0; level < n; ++level) {
+        const uint64_t bit = 1ULL << level;
+        const int branch = (cube.mask & bit) ? ((cube.value & bit) ? 1 : 0) : 2;
+        if (nodes[at].child[branch] == 0) {
+            nodes[at].child[branch] = (uint32_t)nodes.size();
+            nodes.emplace_back(); // invalidates references into nodes, hence the indices
+        }
+        at = nodes[at].child[branch];
+        enter(nodes[at]);
+    }
+    if (nextAtLeaf.size() <= id) {
+        nextAtLeaf.resize((size_t)id + 1, 0);
+        alive.resize((size_t)id + 1, false);
+    }
+    nextAtLeaf[id] = nodes[at].child[0];
+    nodes[at].child[0] = id + 1;
+    alive[id] = true;
+}
+
+// the id stays on its leaf's list, only the counts on the way down tell it is gone
+void CubeIndex::erase(const Cube& cube, uint32_t id) {
+    if (!has(id)) return;
+    alive[id] = false;
+    uint32_t at = 0;
+    --nodes[0].count;
+    for (int level = 0; level < n; ++level) {
+        const uint64_t bit = 1ULL << level;
+        at = nodes[at].child[(cube.mask & bit) ? ((cube.value & bit) ? 1 : 0) : 2];
+        --nodes[at].count;
+    }
+}
@@ -0,0 +1,101 @@
+//
+// Containment / intersection lookups over a changing set of cubes (consensus and PLA input).
+//
+
+#ifndef QM_DD1_CUBEINDEX_H
+#define QM_DD1_CUBEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Cube.h"
+
+// Ternary trie over the variables: level i branches on variable i being 0, 1 or free, and the
+// cubes hang off the leaves under the id the caller gives them. A query only walks the branches
+// its cube allows (a fixed literal rules out the other value), and skips the subtrees whose
+// cubes were all erased or all fail it on a variable further down (from a summary of their
+// literals kept in each node), so a lookup costs about the matching cubes instead of all of them.
+class CubeIndex {
+public:
+    enum Query {
+        Covering, // cubes that cover the query cube
+        Inside,   // cubes the query cube covers
+        Meeting   // cubes with a point in common with it
+    };
+
+    explicit CubeIndex(int nbVars);
+
+    // ids are small integers chosen by the caller (an index into its own list), each used once
+    void insert(const Cube& cube, uint32_t id);
+    void erase(const Cube& cube, uint32_t id);
+    bool has(uint32_t id) const { return id < alive.size() && alive[id]; }
+
+    // visit(id) for each cube in the index that matches cube (and fixes every variable of
+    // `fixing`), until visit returns true; returns whether it stopped. The index must not
+    // change during the walk.
+    template <class Visit>
+    bool find(const Cube& cube, Query query, Visit&& visit, uint64_t fixing = 0) const;
+
+private:
+    struct Node {
+        uint32_t child[3] = {0, 0, 0}; // 0 / 1 / free, 0 when absent (the root is no one's child);
+                                       // at the last level child[0] is the first id + 1 instead
+        uint32_t count = 0;            // cubes still in the subtree
+        // literals of the cubes ever inserted below (erasing doesn't update them, which only
+        // makes them prune less): the variables all of them fix to 1 / to 0, any of them fixes
+        uint64_t allOnes = ~0ULL;
+        uint64_t allZeros = ~0ULL;
+        uint64_t anyFixed = 0;
+    };
+
+    int n;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> nextAtLeaf; // id -> next id + 1 on the same leaf
+    std::vector<bool> alive;
+};
+
+template <class Visit>
+bool CubeIndex::find(const Cube& cube, Query query, Visit&& visit, uint64_t fixing) const {
+    // depth first; each level leaves at most two siblings behind
+    struct Step { uint32_t node; int level; };
+    Step pending[2 * 64 + 2];
+    size_t top = 0;
+    pending[top++] = {0, 0};
+    while (top > 0) {
+        const Step step = pending[--top];
+        const Node& node = nodes[step.node];
+        if (node.count == 0) continue;
+        // every query fails on a variable all the cubes below fix the other way; a cube covering
+        // this one leaves free all that it leaves free, one inside it fixes all it fixes
+        if ((node.allOnes & cube.mask & ~cube.value) != 0 || (node.allZeros & cube.value) != 0) continue;
+        if (query == Covering && ((node.allOnes | node.allZeros) & ~cube.mask) != 0) continue;
+        if (query == Inside && (node.anyFixed & cube.mask) != cube.mask) continue;
+        if ((node.anyFixed & fixing) != fixing) continue;
+        if (step.level == n) {
+            for (uint32_t id = node.child[0]; id != 0; id = nextAtLeaf[id - 1])
+                if (alive[id - 1] && visit(id - 1)) return true;
+            continue;
+        }
+        const uint64_t bit = 1ULL << step.level;
+        const bool fixed = (cube.mask & bit) != 0;
+        const int literal = (cube.value & bit) ? 1 : 0;
+        auto push = [&](int branch) {
+            if (node.child[branch] != 0) pending[top++] = {node.child[branch], step.level + 1};
+        };
+        // which branches can hold a match at this variable
+        if (fixed) {
+            push(literal);
+            if (query != Inside) push(2);
+        } else {
+            push(2);
+            if (query != Covering) {
+                push(0);
+                push(1);
+            }
+        }
+    }
+    return false;
+}
+
+#endif //QM_DD1_CUBEINDEX_H
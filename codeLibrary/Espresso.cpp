@@ -0,0 +1,322 @@
+//
+// Heuristic two-level minimizer in the style of Espresso, for functions too big for exact QM.
+//
+
+#include "Espresso.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_set>
+
+#include "Profile.h"
+
+namespace {
+
+// REDUCE/EXPAND/IRREDUNDANT rounds after the first one; the cost rarely improves after a few
+const int kMaxRounds = 20;
+
+inline bool disjoint(const Cube& a, const Cube& b) {
+    return ((a.value ^ b.value) & a.mask & b.mask) != 0;
+}
+
+// a restricted to the subspace of p (they must intersect): the variables p fixes are dropped
+inline Cube cofactor(const Cube& a, const Cube& p) {
+    Cube c;
+    c.mask = a.mask & ~p.mask;
+    c.value = a.value & c.mask;
+    return c;
+}
+
+// smallest cube containing both a and b
+inline Cube supercube(const Cube& a, const Cube& b) {
+    Cube c;
+    c.mask = a.mask & b.mask & ~(a.value ^ b.value);
+    c.value = a.value & c.mask;
+    return c;
+}
+
+Cover cofactorCover(const Cover& f, const Cube& p) {
+    Cover result;
+    for (const Cube& c : f)
+        if (!disjoint(c, p)) result.push_back(cofactor(c, p));
+    return result;
+}
+
+// Splitting variable for the recursions: the one fixed in most cubes among those that appear in
+// both polarities (binate); if the cover is unate, the most used one. Returns 0 for a cover
+// with no literals at all.
+uint64_t splitVariable(const Cover& f, bool* binate) {
+    int ones[64] = {0};
+    int zeros[64] = {0};
+    for (const Cube& c : f) {
+        uint64_t bits = c.mask;
+        while (bits) {
+            int i = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if ((c.value >> i) & 1ULL) ++ones[i];
+            else ++zeros[i];
+        }
+    }
+    int best = -1;
+    int bestScore = 0;
+    bool bestBinate = false;
+    for (int i = 0; i < 64; ++i) {
+        int score = ones[i] + zeros[i];
+        if (score == 0) continue;
+        bool both = ones[i] > 0 && zeros[i] > 0;
+        if ((both && !bestBinate) || (both == bestBinate && score > bestScore)) {
+            best = i;
+            bestScore = score;
+            bestBinate = both;
+        }
+    }
+    if (binate != nullptr) *binate = bestBinate;
+    return best < 0 ? 0 : 1ULL << best;
+}
+
+} // namespace
+
+size_t Espresso::literalCount(const Cover& f) {
+    size_t count = 0;
+    for (const Cube& c : f) count += (size_t)c.literalCount();
+    return count;
+}
+
+// complement(f) = x' complement(f_x') + x complement(f_x), where a cube found in both halves is
+// kept once without the literal on x
+Cover Espresso::complement(const Cover& f) {
+    if (f.empty()) return {Cube()};
+    for (const Cube& c : f)
+        if (c.mask == 0) return {};
+    if (f.size() == 1) {
+        // De Morgan: one cube per literal, with that literal flipped
+        Cover result;
+        uint64_t bits = f[0].mask;
+        while (bits) {
+            uint64_t bit = bits & (~bits + 1);
+            bits &= bits - 1;
+            Cube c;
+            c.mask = bit;
+            c.value = ~f[0].value & bit;
+            result.push_back(c);
+        }
+        return result;
+    }
+
+    uint64_t bit = splitVariable(f, nullptr);
+    Cube low, high;
+    low.mask = high.mask = bit;
+    high.value = bit;
+    Cover c0 = complement(cofactorCover(f, low));
+    Cover c1 = complement(cofactorCover(f, high));
+
+    std::unordered_set<Cube, CubeHash> inHigh(c1.begin(), c1.end());
+    std::unordered_set<Cube, CubeHash> shared;
+    Cover result;
+    result.reserve(c0.size() + c1.size());
+    for (const Cube& c : c0) {
+        if (inHigh.count(c)) {
+            shared.insert(c);
+            result.push_back(c);
+        } else {
+            Cube withLiteral = c;
+            withLiteral.mask |= bit;
+            result.push_back(withLiteral);
+        }
+    }
+    for (const Cube& c : c1) {
+        if (shared.count(c)) continue;
+        Cube withLiteral = c;
+        withLiteral.mask |= bit;
+        withLiteral.value |= bit;
+        result.push_back(withLiteral);
+    }
+    return result;
+}
+
+bool Espresso::tautology(const Cover& f, uint64_t space) {
+    if (f.empty()) return false;
+    for (const Cube& c : f)
+        if (c.mask == 0) return true;
+
+    // not enough points to fill the space
+    const int freeVars = popcount64(space);
+    double volume = 0.0;
+    for (const Cube& c : f) volume += std::ldexp(1.0, freeVars - c.literalCount());
+    if (volume < std::ldexp(1.0, freeVars)) return false;
+
+    bool binate = false;
+    uint64_t bit = splitVariable(f, &binate);
+    // a unate cover is a tautology only if it has the universal cube (checked above)
+    if (!binate) return false;
+
+    Cube low, high;
+    low.mask = high.mask = bit;
+    high.value = bit;
+    return tautology(cofactorCover(f, low), space & ~bit) &&
+           tautology(cofactorCover(f, high), space & ~bit);
+}
+
+bool Espresso::covers(const Cover& f, const Cube& c, int nbVars) {
+    return tautology(cofactorCover(f, c), Cube::fullMask(nbVars) & ~c.mask);
+}
+
+// Expansion of one cube c against the off-set: for each off-set cube r keep the bits where c and
+// r conflict. A literal can be raised unless it is the only conflict left with some r. Literals
+// are tried in order of how many other cubes of f would need them raised to be covered by c.
+Cover Espresso::expand(const Cover& f, const Cover& offSet) {
+    Cover cubes = f;
+    // biggest cubes first: they are the most likely to swallow the others
+    std::stable_sort(cubes.begin(), cubes.end(),
+                     [](const Cube& a, const Cube& b) { return a.literalCount() < b.literalCount(); });
+    std::vector<char> covered(cubes.size(), 0);
+    std::vector<uint64_t> conflicts(offSet.size());
+
+    for (size_t i = 0; i < cubes.size(); ++i) {
+        if (covered[i]) continue;
+        Cube c = cubes[i];
+
+        int blocking[64] = {0}; // off-set cubes whose only conflict is this literal
+        for (size_t k = 0; k < offSet.size(); ++k) {
+            conflicts[k] = (c.value ^ offSet[k].value) & c.mask & offSet[k].mask;
+            if (popcount64(conflicts[k]) == 1) ++blocking[__builtin_ctzll(conflicts[k])];
+        }
+
+        int wanted[64] = {0};
+        for (size_t j = 0; j < cubes.size(); ++j) {
+            if (j == i || covered[j]) continue;
+            uint64_t need = (c.mask & ~cubes[j].mask) | ((c.value ^ cubes[j].value) & c.mask & cubes[j].mask);
+            while (need) {
+                ++wanted[__builtin_ctzll(need)];
+                need &= need - 1;
+            }
+        }
+        std::vector<int> order;
+        for (int b = 0; b < 64; ++b)
+            if ((c.mask >> b) & 1ULL) order.push_back(b);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return wanted[a] > wanted[b]; });
+
+        // a literal blocked now stays blocked, so one pass gives a prime
+        for (int b : order) {
+            if (blocking[b] > 0) continue;
+            uint64_t bit = 1ULL << b;
+            c.mask &= ~bit;
+            c.value &= ~bit;
+            for (size_t k = 0; k < offSet.size(); ++k) {
+                if (!(conflicts[k] & bit)) continue;
+                conflicts[k] &= ~bit;
+                if (popcount64(conflicts[k]) == 1) ++blocking[__builtin_ctzll(conflicts[k])];
+            }
+        }
+
+        cubes[i] = c;
+        for (size_t j = 0; j < cubes.size(); ++j)
+            if (j != i && !covered[j] && c.covers(cubes[j])) covered[j] = 1;
+    }
+
+    Cover result;
+    for (size_t i = 0; i < cubes.size(); ++i)
+        if (!covered[i]) result.push_back(cubes[i]);
+    return result;
+}
+
+// A cube is redundant when the rest of the cover (plus don't cares) restricted to it is a
+// tautology. Small cubes are tried first since they are the cheapest to lose.
+Cover Espresso::irredundant(const Cover& f, const Cover& dontCares) {
+    uint64_t space = 0;
+    for (const Cube& c : f) space |= c.mask;
+    for (const Cube& c : dontCares) space |= c.mask;
+
+    std::vector<size_t> order(f.size());
+    for (size_t i = 0; i < f.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return f[a].literalCount() > f[b].literalCount(); });
+
+    std::vector<char> removed(f.size(), 0);
+    for (size_t i : order) {
+        Cover rest;
+        for (size_t j = 0; j < f.size(); ++j)
+            if (j != i && !removed[j] && !disjoint(f[j], f[i])) rest.push_back(cofactor(f[j], f[i]));
+        for (const Cube& d : dontCares)
+            if (!disjoint(d, f[i])) rest.push_back(cofactor(d, f[i]));
+        if (tautology(rest, space & ~f[i].mask)) removed[i] = 1;
+    }
+
+    Cover result;
+    for (size_t i = 0; i < f.size(); ++i)
+        if (!removed[i]) result.push_back(f[i]);
+    return result;
+}
+
+// Each cube c becomes c AND the supercube of the part of c nothing else covers, i.e. of
+// complement((f - c + D) restricted to c). Large cubes go first, and each reduction is seen by
+// the following ones. A cube with nothing of its own left is dropped.
+Cover Espresso::reduce(const Cover& f, const Cover& dontCares) {
+    Cover cubes = f;
+    std::vector<size_t> order(cubes.size());
+    for (size_t i = 0; i < cubes.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return cubes[a].literalCount() < cubes[b].literalCount(); });
+
+    std::vector<char> removed(cubes.size(), 0);
+    for (size_t i : order) {
+        Cover rest;
+        for (size_t j = 0; j < cubes.size(); ++j)
+            if (j != i && !removed[j] && !disjoint(cubes[j], cubes[i])) rest.push_back(cofactor(cubes[j], cubes[i]));
+        for (const Cube& d : dontCares)
+            if (!disjoint(d, cubes[i])) rest.push_back(cofactor(d, cubes[i]));
+        Cover own = complement(rest);
+        if (own.empty()) {
+            removed[i] = 1;
+            continue;
+        }
+        Cube hull = own[0];
+        for (size_t k = 1; k < own.size(); ++k) hull = supercube(hull, own[k]);
+        cubes[i].mask |= hull.mask;
+        cubes[i].value |= hull.value;
+    }
+
+    Cover result;
+    for (size_t i = 0; i < cubes.size(); ++i)
+        if (!removed[i]) result.push_back(cubes[i]);
+    return result;
+}
+
+Cover Espresso::minimize(int nbVars, const std::vector<uint64_t>& onSet, const std::vector<uint64_t>& dontCares) {
+    std::unordered_set<uint64_t> onTerms(onSet.begin(), onSet.end());
+    Cover f, d;
+    for (uint64_t t : onTerms) f.push_back(Cube::fromTerm(t, nbVars));
+    for (uint64_t t : std::unordered_set<uint64_t>(dontCares.begin(), dontCares.end()))
+        if (!onTerms.count(t)) d.push_back(Cube::fromTerm(t, nbVars));
+    return minimize(nbVars, std::move(f), std::move(d));
+}
+
+Cover Espresso::minimize(int nbVars, Cover f, Cover d) {
+    QM_PROFILE_TIMER("Espresso::minimize");
+    if (f.empty()) return {};
+    // hash order isn't stable across libraries, start from sorted cubes
+    auto byCube = [](const Cube& a, const Cube& b) { return a.mask != b.mask ? a.mask < b.mask : a.value < b.value; };
+    sort(f.begin(), f.end(), byCube);
+    sort(d.begin(), d.end(), byCube);
+    f.erase(unique(f.begin(), f.end()), f.end());
+    d.erase(unique(d.begin(), d.end()), d.end());
+
+    Cover everything = f;
+    everything.insert(everything.end(), d.begin(), d.end());
+    const Cover offSet = complement(everything);
+
+    f = irredundant(expand(f, offSet), d);
+    QM_PROFILE_APPEND("espresso.offSetCubes", offSet.size());
+    QM_PROFILE_APPEND("espresso.cubesPerRound", f.size());
+    for (int round = 0; round < kMaxRounds; ++round) {
+        Cover g = irredundant(expand(reduce(f, d), offSet), d);
+        QM_PROFILE_APPEND("espresso.cubesPerRound", g.size());
+        bool better = g.size() < f.size() || (g.size() == f.size() && literalCount(g) < literalCount(f));
+        if (!better) break;
+        f = std::move(g);
+    }
+
+    sort(f.begin(), f.end(), [nbVars](const Cube& a, const Cube& b) { return a.toPattern(nbVars) < b.toPattern(nbVars); });
+    return f;
+}
@@ -0,0 +1,48 @@
+//
+// Heuristic two-level minimizer in the style of Espresso, for functions too big for exact QM.
+//
+
+#ifndef QM_DD1_ESPRESSO_H
+#define QM_DD1_ESPRESSO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Cube.h"
+
+using Cover = std::vector<Cube>;
+
+// The usual loop on a cover F of the on-set, with D the don't cares and R the off-set:
+//   F = IRREDUNDANT(EXPAND(F))
+//   repeat F = IRREDUNDANT(EXPAND(REDUCE(F))) while the cost (cubes, then literals) drops
+// The result is a cover of prime, irredundant cubes, but not necessarily a minimum one.
+// Cubes work on up to 64 variables.
+class Espresso {
+public:
+    // nbVars variables, on-set and don't-care terms; returns the cover sorted by pattern
+    static Cover minimize(int nbVars, const std::vector<uint64_t>& onSet, const std::vector<uint64_t>& dontCares);
+    // same from covers of any cubes (a PLA's lines), nothing is expanded to terms. A point in
+    // both is a don't care, as in espresso
+    static Cover minimize(int nbVars, Cover onSet, Cover dontCares);
+
+    // each cube made as large as possible without touching a cube of offSet; cubes that end
+    // up inside an expanded cube are dropped
+    static Cover expand(const Cover& f, const Cover& offSet);
+    // drops cubes covered by the rest of f together with dontCares
+    static Cover irredundant(const Cover& f, const Cover& dontCares);
+    // shrinks each cube to the smallest cube still needed next to the others
+    static Cover reduce(const Cover& f, const Cover& dontCares);
+
+    // cover of everything f doesn't cover (unate recursive paradigm)
+    static Cover complement(const Cover& f);
+    // f covers the whole space of the variables in `space`
+    static bool tautology(const Cover& f, uint64_t space);
+    // every point of c (over nbVars variables) is in f
+    static bool covers(const Cover& f, const Cube& c, int nbVars);
+
+    // number of literals over all cubes of f
+    static size_t literalCount(const Cover& f);
+};
+
+#endif //QM_DD1_ESPRESSO_H
@@ -4,153 +4,531 @@
 
 #include "FileManip.h"
 
+#include <charconv>
+
+#include "MappedFile.h"
+#include "Npn.h"
+#include "PIChart.h"
 #include "PItable.h"
+#include "Profile.h"
+#include "ResultCache.h"
+#include "ThreadPool.h"
+#include "Verifier.h"
+#include "Zdd.h"
 
 
 //Function 1: parseTerms
-
- std::vector<int> FileManip::parseTerms(const std::string &line, char expectedPrefix) {
-    vector<int> nums;
-    if (line.empty()) return nums;
+// Reads "m1, m4, m8-15": the line has to start with the prefix, each term may repeat it, and
+// a-b stands for every term from a to b. Works on the bytes in place (std::from_chars, nothing
+// allocated per token); a problem is reported in `error` with its column.
+
+ bool FileManip::parseTerms(std::string_view line, char expectedPrefix, Term maxValue, std::vector<Term> &nums, std::string &error,
+                            size_t maxTerms) {
+    nums.clear();
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f'; };
+    const size_t end = line.size();
+    size_t pos = 0;
+    auto skipSpaces = [&]() { while (pos < end && isSpace(line[pos])) ++pos; };
 
     //We first find the first non-space character and compare it with the expected (line1-> number, line2->m, like3->d)
-    size_t first = line.find_first_not_of(" \t\r\n");
-    if (first == string::npos) return nums;
-    if (tolower(line[first]) != expectedPrefix) {
-        cerr << "Error: Line must start with '" << expectedPrefix << "'. Instead got: " << line << endl;
-        exit(1);
-    }
-
-    string token;
-    stringstream ss(line);
-    while (getline(ss, token, ',')) {
-        // we just remove whitespace
-        token.erase(remove_if(token.begin(), token.end(),
-                              [](unsigned char c){ return c=='\r' || isspace(c); }),
-                    token.end());
-        if (token.empty()) continue; // skip blank tokens from
-
-        //per-token prefix
-        if (isalpha(static_cast<unsigned char>(token[0]))) {
-            if (tolower(token[0]) != expectedPrefix) {
-                //error handling when we don't have the right refix
-                cerr << "Invalid token prefix: " << token
-                     << " (expected '" << expectedPrefix << "')\n";
-                exit(1);
-            }
-            if (token.size() == 1) {
-
-                continue;
-            }
-            token.erase(0,1); //strip prefix
+    // the token around `from`, only built when something is wrong with it
+    auto tokenAt = [&](size_t from) {
+        size_t stop = line.find(',', from);
+        string_view token = line.substr(from, (stop == string_view::npos ? end : stop) - from);
+        while (!token.empty() && isSpace(token.back())) token.remove_suffix(1);
+        return string(token);
+    };
+    // every message is "column C: <what>: <details>", loadFunction puts "Error: line L, " in front
+    auto fail = [&](size_t at, const string& message) {
+        error = "column " + to_string(at + 1) + ": " + message;
+        return false;
+    };
+
+    skipSpaces();
+    if (pos == end) return true;
+    if (tolower((unsigned char)line[pos]) != expectedPrefix)
+        return fail(pos, "Invalid line start: " + tokenAt(pos) + " (expected '" + string(1, expectedPrefix) + "')");
+    // one number, with an optional prefix in front
+    auto readNumber = [&](size_t tokenStart, Term& value) {
+        if (pos < end && isalpha((unsigned char)line[pos])) {
+            if (tolower((unsigned char)line[pos]) != expectedPrefix)
+                return fail(pos, "Invalid token prefix: " + tokenAt(tokenStart) + " (expected '" + string(1, expectedPrefix) + "')");
+            ++pos;
+            skipSpaces();
+        }
+        auto parsed = std::from_chars(line.data() + pos, line.data() + end, value);
+        if (parsed.ec == std::errc::result_out_of_range)
+            return fail(pos, "Invalid number: " + tokenAt(tokenStart) + " does not fit in 64 bits");
+        if (parsed.ec != std::errc())
+            return fail(pos, "Invalid number: " + tokenAt(tokenStart));
+        pos = (size_t)(parsed.ptr - line.data());
+        skipSpaces();
+        return true;
+    };
+
+    while (pos < end) {
+        skipSpaces();
+        if (pos == end) break;
+        if (line[pos] == ',') { ++pos; continue; } // skip blank tokens
+        size_t tokenStart = pos;
+
+        // a lone prefix (e.g. an empty "d" line) has no number
+        if (isalpha((unsigned char)line[pos]) && tolower((unsigned char)line[pos]) == expectedPrefix) {
+            size_t after = pos + 1;
+            while (after < end && isSpace(line[after])) ++after;
+            if (after == end || line[after] == ',') { pos = after; continue; }
         }
 
-        // check that all digits
-        if (token.empty() ||
-            !all_of(token.begin(), token.end(),
-                    [](unsigned char c){ return isdigit(c); })) {
-            cerr << "Invalid number: " << token << endl;
-            exit(1);
-                    }
+        Term low = 0;
+        if (!readNumber(tokenStart, low)) return false;
+        Term high = low;
+        if (pos < end && line[pos] == '-') {
+            ++pos;
+            skipSpaces();
+            if (!readNumber(tokenStart, high)) return false;
+            if (high < low) return fail(tokenStart, "Invalid range: " + tokenAt(tokenStart) + " (the end is below the start)");
+        }
+        if (pos < end && line[pos] != ',') return fail(pos, "Invalid number: " + tokenAt(tokenStart));
 
-        nums.push_back(stoi(token));
+        if (high > maxValue) {
+            return fail(tokenStart, "Invalid value: " + to_string(high) + " does not fit in " + to_string(popcount64(maxValue)) +
+                                    " bits (allowed 0.." + to_string(maxValue) + ")");
+        }
+        // checked before expanding: high - low can be close to 2^64
+        if (nums.size() > maxTerms || high - low >= (Term)(maxTerms - nums.size()))
+            return fail(tokenStart, "Too many terms: more than " + to_string(maxTerms) + " (" + tokenAt(tokenStart) +
+                                    " is too big a range)");
+        for (Term t = low; ; ++t) {
+            nums.push_back(t);
+            if (t == high) break;
+        }
     }
 
-    return nums;
+    return true;
 }
 
 
 
 // Function 2: toBinary
 
- string FileManip::toBinary(int num, int bits) {
+ string FileManip::toBinary(Term num, int bits) {
     if (bits < 1 || bits > 64) {
         cerr << "Error: bits must be in [1, 64], got " << bits << ".\n"; //our code only accepts upto 64 bits
         exit(1);
     }
-    if (num < 0) {
-        cerr << "Error: negative term " << num << " is invalid.\n"; //we dont accept negative terms
-        exit(1);
-    }
-
+    // terms are unsigned, so negative values were already rejected by the parser
 
     uint64_t maxVal = (bits == 64) ? std::numeric_limits<uint64_t>::max()
                                    : ((1ULL << bits) - 1ULL);
 
-    if (static_cast<uint64_t>(num) > maxVal) {
+    if (num > maxVal) {
         cerr << "Error: value " << num << " does not fit in " //if the value is bigger than the number of bits specified at the top of the file
              << bits << " bits (allowed 0.." << maxVal << ").\n";  //shows the max value for the bits allowed
         exit(1);
     }
 
-    string bin = bitset<64>(num).to_string(); // 64 bits max
-    return bin.substr(64 - bits); //keep only last 'bits' characters
+    // write the bits straight into a string of the right width, MSB first
+    string bin((size_t)bits, '0');
+    for (int i = 0; i < bits; ++i)
+        if ((num >> i) & 1ULL) bin[(size_t)(bits - 1 - i)] = '1';
+    return bin;
 }
 
- int FileManip::doQMmin() {
+ // Function 2b: read and check a function file. The file is memory-mapped and parsed in place.
+ bool FileManip::loadFunction(const std::string &filePath, BooleanFunction &function, std::string &error) {
+    MappedFile file(filePath);
+    if (!file.isOpen()) {
+        error = "Error: file not found: " + filePath;
+        return false;
+    }
+    return parseFunction(file.contents(), function, error);
+}
+
+ // the text of a function file: the variable count, then a minterm line and a don't care line
+ // per output (3 lines for a single-output function). The lines are views into the text.
+ bool FileManip::parseFunction(std::string_view text, BooleanFunction &function, std::string &error) {
+    std::vector<std::string_view> lines;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t stop = text.find('\n', pos);
+        if (stop == std::string_view::npos) stop = text.size();
+        lines.push_back(text.substr(pos, stop - pos));
+        pos = stop + 1;
+    }
+    // blank lines at the end don't count, but the don't care line of the last output may be one
+    // of them (and the minterm line too, for a single output): with the blanks gone an even
+    // count means that don't care line is missing, so it comes back empty
+    auto blank = [](std::string_view line) {
+        return line.find_first_not_of(" \t\r") == std::string_view::npos;
+    };
+    size_t kept = lines.size();
+    while (kept > 0 && blank(lines[kept - 1])) --kept;
+    kept = std::max(kept, std::min(lines.size(), (size_t)3));
+    if (kept % 2 == 0) ++kept;
+    lines.resize(kept);
+//since we need to have 3 lines even if there are no dont cares
+    if (lines.size() < 3) {
+        error = "Error: file must have at least 3 lines.";
+        return false;
+    }
+    if (lines.size() % 2 == 0) {
+        error = "Error: every output needs a minterm line and a don't care line.";
+        return false;
+    }
+    const size_t outputs = (lines.size() - 1) / 2;
+    if (outputs > 64) {
+        error = "Error: at most 64 outputs are supported.";
+        return false;
+    }
+//check the maximum number of variables or if there are no variables
+    std::string_view line1 = lines[0];
+    while (!line1.empty() && isspace((unsigned char)line1.front())) line1.remove_prefix(1);
+    while (!line1.empty() && isspace((unsigned char)line1.back())) line1.remove_suffix(1);
+    int n = 0;
+    auto parsed = std::from_chars(line1.data(), line1.data() + line1.size(), n);
+    if (line1.empty() || parsed.ec != std::errc() || parsed.ptr != line1.data() + line1.size()) {
+        error = "Error: first line must be the number of variables, got: " + string(line1);
+        return false;
+    }
+    if (n < 1 || n > 64) {
+        error = "Error: number of variables must be between 1 and 64.";
+        return false;
+    }
+//here we need to specify the prefix for each like to use the parseTerms function (every term has to fit in n bits)
+    function.nbVars = n;
+    function.minterms.assign(outputs, {});
+    function.dontCares.assign(outputs, {});
+    size_t listed = 0; // kMaxListedTerms is for the whole file
+    for (size_t o = 0; o < outputs; ++o) {
+        const size_t mLine = 1 + 2 * o;
+        if (!parseTerms(lines[mLine], 'm', Cube::fullMask(n), function.minterms[o], error, kMaxListedTerms - listed)) { // or 'M' supported automatically
+            error = "Error: line " + to_string(mLine + 1) + ", " + error;
+            return false;
+        }
+        listed += function.minterms[o].size();
+        if (!parseTerms(lines[mLine + 1], 'd', Cube::fullMask(n), function.dontCares[o], error, kMaxListedTerms - listed)) {
+            error = "Error: line " + to_string(mLine + 2) + ", " + error;
+            return false;
+        }
+        listed += function.dontCares[o].size();
+    }
+    return true;
+}
+
+ // exact QM only ever touches the listed terms, so what matters is their count and how many of
+ // them are next to each other (each pair combines), not the number of variables
+ bool FileManip::autoPicksExact(const BooleanFunction &function) {
+    if (function.nbVars <= kAutoExactVars) return true;
+    size_t terms = 0;
+    for (size_t o = 0; o < function.outputCount(); ++o) terms += function.minterms[o].size() + function.dontCares[o].size();
+    if (terms <= kAutoExactTerms) return true;
+    if (terms > kAutoMaxExactTerms) return false;
+    size_t points = 0, neighbours = 0;
+    for (size_t o = 0; o < function.outputCount(); ++o) {
+        unordered_set<Term> care(function.minterms[o].begin(), function.minterms[o].end());
+        care.insert(function.dontCares[o].begin(), function.dontCares[o].end());
+        points += care.size();
+        for (Term t : care)
+            for (int i = 0; i < function.nbVars; ++i)
+                if (care.count(t ^ (1ULL << i))) ++neighbours;
+    }
+    return (double)neighbours <= kAutoExactDegree * (double)points;
+}
+
+ // Function 2c: the minimization itself, without any prompts. verbose prints the intermediate
+ // tables (implicants, PIs, EPIs) the interactive front end shows. With a cache directory a
+ // function seen before (same terms and options) is read back instead of minimized again.
+ MinimizationResult FileManip::minimize(const BooleanFunction &function, const RunOptions &options, ThreadPool *pool, bool verbose) {
+    QM_PROFILE_TIMER("minimize");
+    const bool heuristic = options.engine == Engine::Heuristic ||
+                           (options.engine == Engine::Auto && !autoPicksExact(function));
+    // every result is checked against the function on the way out, cache hits included
+    auto passes = [&](MinimizationResult& result) {
+        if (!options.verify || Verifier::checkResult(function, result, result.verifyError)) return true;
+        cerr << result.verifyError << "\n";
+        return false;
+    };
+    if (options.cacheDir.empty()) {
+        MinimizationResult result = minimizeUncached(function, heuristic, options, pool, verbose);
+        passes(result);
+        return result;
+    }
+
+    // entries are stored for the NP-canonical form, so a function that only differs by a
+    // permutation / complementation of its inputs hits the same one (remapped on the way out)
+    NpnTransform transform;
+    const BooleanFunction canonical = Npn::canonicalize(function, transform, false);
+    const CacheKey key = ResultCache::key(canonical, heuristic, options);
+    MinimizationResult result;
+    if (ResultCache::load(options.cacheDir, key, result)) {
+        QM_PROFILE_ADD("cache.hits", 1);
+        Npn::mapResult(result, transform, false);
+        result.fromCache = true;
+        if (verbose) cout << "\nFound in the cache (" << key.toHex() << "), skipping the minimization.\n";
+        if (passes(result)) return result;
+        // a bad entry would be served on every later run: drop it and minimize again
+        QM_PROFILE_ADD("cache.evictions", 1);
+        ResultCache::remove(options.cacheDir, key);
+        cerr << "Warning: dropped the cache entry " << key.toHex() << ", minimizing again\n";
+    } else {
+        QM_PROFILE_ADD("cache.misses", 1);
+    }
+    result = minimizeUncached(function, heuristic, options, pool, verbose);
+    // only a result that passed the check (or wasn't checked) goes into the cache
+    if (!passes(result)) return result;
+    MinimizationResult stored = result;
+    Npn::mapResult(stored, transform, true);
+    if (!ResultCache::store(options.cacheDir, key, stored))
+        cerr << "Warning: could not write the cache entry " << key.toHex() << " to " << options.cacheDir << "\n";
+    return result;
+}
+
+ MinimizationResult FileManip::minimizeUncached(const BooleanFunction &function, bool heuristic, const RunOptions &options, ThreadPool *pool, bool verbose) {
+    const int n = function.nbVars;
+    const size_t outputCount = function.outputCount();
+    MinimizationResult result;
+    result.outputCount = outputCount;
+    result.heuristic = heuristic;
+    // Espresso-style run: one cover instead of the PI chart, reported like an exact solution.
+    // With several outputs each one is minimized on its own and equal cubes are shared.
+    auto runHeuristic = [&] {
+        if (verbose) cout << "\nHeuristic minimization (expand / irredundant / reduce), the result is not guaranteed minimum.\n";
+        vector<Cover> covers;
+        for (size_t o = 0; o < outputCount; ++o)
+            covers.push_back(Espresso::minimize(n, function.minterms[o], function.dontCares[o]));
+        return heuristicResult(covers, n, verbose);
+    };
+    if (result.heuristic) return runHeuristic();
+
+    if (options.engine == Engine::Zdd && outputCount == 1) {
+        // primes straight from the diagrams, no initial implicants and no combining passes
+        ZddStats stats;
+        result.primes = Zdd::primeImplicants(n, function.minterms[0], function.dontCares[0], &stats);
+        if (verbose) {
+            cout << "\nImplicit prime generation: BDD " << stats.bddNodes << " nodes, prime ZDD " << stats.zddNodes
+                 << " nodes, " << stats.primes << " primes, " << stats.needed << " of them cover a minterm\n";
+            // only for the listing below, the chart works from the cubes
+            for (Implicant& prime : result.primes) {
+                for (const vector<Term>* terms : {&function.minterms[0], &function.dontCares[0]})
+                    for (Term t : *terms)
+                        if (prime.cube.contains(t)) prime.covered.push_back(t);
+                sort(prime.covered.begin(), prime.covered.end());
+                prime.covered.erase(unique(prime.covered.begin(), prime.covered.end()), prime.covered.end());
+            }
+        }
+    } else {
+        if (options.engine == Engine::Zdd && verbose)
+            cout << "\nNote: the ZDD engine takes single-output functions, using the combining passes.\n";
+        vector<Implicant> initial = (outputCount == 1)
+            ? Implicant::buildInitialImplicants(n, function.minterms[0], function.dontCares[0])
+            : Implicant::buildMultiOutputImplicants(n, function.minterms, function.dontCares);
+        if (verbose) Implicant::printImplicants(initial, n, (int)outputCount);
+        // Generate Prime Implicants (the combining passes run on the thread pool)
+        result.primes = Implicant::generatePrimeImplicants(initial, n, pool);
+    }
+
+    if (verbose) {
+        // Build quick sets for display classification
+        unordered_set<Term> mintermSet, dontCareSet;
+        for (size_t o = 0; o < outputCount; ++o) {
+            mintermSet.insert(function.minterms[o].begin(), function.minterms[o].end());
+            dontCareSet.insert(function.dontCares[o].begin(), function.dontCares[o].end());
+        }
+        Implicant::printPrimeImplicants(result.primes, n, mintermSet, dontCareSet, (int)outputCount);
+    }
+    if (!solveChart(result, function.minterms, n, options, pool, verbose)) return runHeuristic();
+    return result;
+}
+
+ // Function 2d: a heuristic run's result from one Espresso cover per output; a cube in several
+ // covers becomes one shared product term
+ MinimizationResult FileManip::heuristicResult(const std::vector<Cover> &covers, int nbVars, bool verbose) {
+    const size_t outputCount = covers.size();
+    MinimizationResult result;
+    result.outputCount = outputCount;
+    result.heuristic = true;
+    unordered_map<Cube, int, CubeHash> index;
+    OutputSelection selection(outputCount);
+    for (size_t o = 0; o < outputCount; ++o) {
+        for (const Cube& c : covers[o]) {
+            auto ins = index.emplace(c, (int)result.primes.size());
+            if (ins.second) {
+                Implicant imp;
+                imp.cube = c;
+                imp.isPureDontCare = false;
+                imp.outputs = 0;
+                result.primes.push_back(std::move(imp));
+            }
+            result.primes[(size_t)ins.first->second].outputs |= 1ULL << o;
+            selection[o].push_back(ins.first->second);
+        }
+    }
+    ProductTerm all;
+    for (size_t i = 0; i < result.primes.size(); ++i) all.insert((int)i);
+    if (!result.primes.empty()) result.solutions.push_back(all);
+    if (outputCount > 1) result.outputSelections.push_back(selection);
+    if (verbose) {
+        size_t literals = 0;
+        for (const Implicant& imp : result.primes) literals += (size_t)imp.cube.literalCount();
+        cout << "Cover: " << result.primes.size() << " cubes, " << literals << " literals\n";
+        for (size_t i = 0; i < result.primes.size(); ++i) {
+            cout << "  [" << i << "] pattern=" << result.primes[i].cube.toPattern(nbVars);
+            if (outputCount > 1) cout << " outputs=" << Implicant::outputsToString(result.primes[i].outputs);
+            cout << "\n";
+        }
+    }
+    return result;
+}
+
+ // Function 2e: the end of an exact run, once result.primes is there: the PI chart over the
+ // minterms of each output, the EPIs, then the cover solver for what they leave
+ bool FileManip::solveChart(MinimizationResult &result, const std::vector<std::vector<Term>> &minterms, int nbVars, const RunOptions &options, ThreadPool *pool, bool verbose) {
+    const size_t outputCount = minterms.size();
+    // one bit row per PI over the minterms (of every output), shared by the essential search and the solver
+    PIChart chart = PIChart::build(result.primes, minterms);
+    result.essential = Implicant::findEssentialPIs(chart);
+    if (verbose) {
+        unordered_set<Term> mintermSet;
+        for (const vector<Term>& terms : minterms) mintermSet.insert(terms.begin(), terms.end());
+        Implicant::printEssentialPIs(result.primes, nbVars, result.essential, mintermSet);
+    }
+    vector<int> remainingColumns = chart.uncoveredColumns(result.essential);
+    for (int c : remainingColumns) result.remaining.push_back(chart.columnMinterms[(size_t)c]);
+    if (verbose) {
+        cout << "Uncovered minterms after EPIs: {";
+        for (size_t i=0;i<remainingColumns.size();++i) {
+            if (outputCount > 1) cout << "F" << chart.columnOutputs[(size_t)remainingColumns[i]] << ":";
+            cout << result.remaining[i];
+            if (i+1<remainingColumns.size()) cout << ",";
+        }
+        cout << "}\n";
+    }
+    bool gaveUp = false;
+    size_t omitted = 0;
+    result.solutions = PItable::solvePIMatrixAndMinimize(result.primes, chart, result.essential, remainingColumns, options.coverMode, options.reduceChart,
+                                                         options.maxSolutions, pool, options.petrickMemoryMB << 20,
+                                                         options.engine == Engine::Auto ? kAutoSearchNodes : 0, &gaveUp, &omitted);
+    if (gaveUp) {
+        cerr << "Note: the exact cover search passed " << kAutoSearchNodes
+                  << " nodes, using the heuristic instead (--engine exact waits for it).\n";
+        return false;
+    }
+    if (omitted != 0) {
+        cerr << "Note: " << omitted << " more minimum covers were found but not shown (--max-solutions 0 lists them all).\n";
+    }
+
+    if (outputCount > 1) {
+        // the chart picks the shared PIs; each output then keeps the ones it needs
+        std::vector<ProductTerm> solutions = result.solutions;
+        if (solutions.empty()) solutions.push_back({});
+        for (const ProductTerm& solution : solutions) {
+            vector<int> selected = result.essential;
+            selected.insert(selected.end(), solution.begin(), solution.end());
+            result.outputSelections.push_back(PItable::outputTerms(result.primes, chart, selected));
+        }
+    }
+    return true;
+}
+
+ // the interactive front end: asks for a test name, shows every step, then offers Verilog
+ int FileManip::doQMmin(const RunOptions& options) {
     string testName;
     cout << "Enter test case (we have 5 tests and they follow this pattern: test1): ";
     cin >> testName;
 //get the test file
     string filePath = "../testcases/" + testName + ".txt";
-    if (!__fs::filesystem::exists(filePath)) {
-        cerr << "Error: file not found: " << filePath << endl;
-        return 1;
-    }
-//since we need to have 3 lines even if there are no dont cares
-    ifstream fin(filePath);
-    string line1, line2, line3;
-    if (!getline(fin, line1) || !getline(fin, line2) || !getline(fin, line3)) {
-        cerr << "Error: file must have exactly 3 lines.\n";
+    BooleanFunction function;
+    string error;
+    if (!loadFunction(filePath, function, error)) {
+        cerr << error << endl;
         return 1;
     }
-//check the maximum number of variables or if there are no variables
-    int n = stoi(line1);
-    if (n < 1 || n > 20) {
-        cerr << "Error: number of variables must be between 1 and 20.\n";
-        return 1;
-    }
-//here we need to specify the prefix for each like to use the parseTerms function
-    vector<int> minterms  = parseTerms(line2, 'm'); // or 'M' supported automatically
-    vector<int> dontCares = parseTerms(line3, 'd');
+    const int n = function.nbVars;
 //to check if the binary conversion was done right
     cout << "\nParsed successfully!\n";
     cout << "Variables: " << n << endl;
-    cout << "Minterms: ";
-    for (int m : minterms) cout << m << " ";
-    cout << "\nDon't cares: ";
-    for (int d : dontCares) cout << d << " ";
-    cout << "\n";
+    if (function.outputCount() > 1) cout << "Outputs: " << function.outputCount() << endl;
+    for (size_t o = 0; o < function.outputCount(); ++o) {
+        if (function.outputCount() > 1) cout << "F" << o << " ";
+        cout << "Minterms: ";
+        for (Term m : function.minterms[o]) cout << m << " ";
+        cout << "\nDon't cares: ";
+        for (Term d : function.dontCares[o]) cout << d << " ";
+        cout << "\n";
+    }
 
     cout << "\nBinary representations:\n";
-    for (int m : minterms)
-        cout << "m" << m << " = " << toBinary(m, n) << endl; //that's what I was talking about n->number of variables
-    for (int d : dontCares)
-        cout << "d" << d << " = " << toBinary(d, n) << endl;
-    vector<Implicant> initial = Implicant::buildInitialImplicants(n, minterms, dontCares);
-    Implicant::printImplicants(initial);
-    // Generate Prime Implicants
-    vector<Implicant> primeImplicants = Implicant::generatePrimeImplicants(initial, n);
-
-    // Build quick sets for display classification
-    unordered_set<int> mintermSet(minterms.begin(), minterms.end());
-    unordered_set<int> dontCareSet(dontCares.begin(), dontCares.end());
-
-    Implicant::printPrimeImplicants(primeImplicants, mintermSet, dontCareSet);
-    vector<int> essential = Implicant::findEssentialPIs(primeImplicants, minterms);
-    Implicant::printEssentialPIs(primeImplicants, essential, mintermSet);
-    vector<int> remain = Implicant::remainingMintermsAfterEPIs(primeImplicants, essential, minterms);
-    cout << "Uncovered minterms after EPIs: {";
-    for (size_t i=0;i<remain.size();++i) {
-        cout << remain[i];
-        if (i+1<remain.size()) cout << ",";
-    }
-    cout << "}\n";
-     std::vector<ProductTerm> minimizedSolutions = PItable::solvePIMatrixAndMinimize(primeImplicants,essential,remain);
-      printMinimizedFunction(primeImplicants, essential, minimizedSolutions, n);
+    for (size_t o = 0; o < function.outputCount(); ++o) {
+        for (Term m : function.minterms[o])
+            cout << "m" << m << " = " << toBinary(m, n) << endl; //that's what I was talking about n->number of variables
+        for (Term d : function.dontCares[o])
+            cout << "d" << d << " = " << toBinary(d, n) << endl;
+    }
+
+    ThreadPool pool(options.threads);
+    MinimizationResult result = minimize(function, options, &pool, true);
+    // minimize already printed what failed; a wrong cover isn't shown nor offered as Verilog
+    if (!result.verifyError.empty()) {
+        cout << "\nThe check failed, no solution is shown for " << testName << ".\n";
+        return 1;
+    }
+    if (result.outputCount > 1) printMultiOutputFunction(result, n);
+    else printMinimizedFunction(result.primes, result.essential, result.solutions, n);
     return 0;
 }
 
+// Every solution as a string, EPIs first (F = ... without the "F = "). With only EPIs there
+// is a single solution made of them; an empty list means F = 0.
+std::vector<std::string> FileManip::solutionStrings(
+    const std::vector<Implicant>& primes,
+    const std::vector<int>& essential,
+    const std::vector<ProductTerm>& minimalSolutions, int nbVars
+) {
+    std::vector<std::string> allSolutions;
+    std::vector<ProductTerm> solutions = minimalSolutions;
+    if (solutions.empty() && !essential.empty()) solutions.push_back({});
+    for (const ProductTerm& selected : solutions) {
+        std::string currentFunc = "";
+
+        // 1. Add Essential PIs
+        for (int idx : essential) {
+            currentFunc += Implicant::patternToBoolean(primes[idx].cube.toPattern(nbVars));
+            currentFunc += " + ";
+        }
+
+        // 2. adding the selected non essential PIs
+        for (int idx : selected) {
+            currentFunc += Implicant::patternToBoolean(primes[idx].cube.toPattern(nbVars));
+            currentFunc += " + ";
+        }
+
+        // cleaning up trailing +s
+        if (currentFunc.size() > 3) {
+            currentFunc.resize(currentFunc.size() - 3);
+        }
+        allSolutions.push_back(currentFunc);
+    }
+    return allSolutions;
+}
+
+std::string FileManip::resultText(const MinimizationResult &result, int nbVars) {
+    std::ostringstream text;
+    if (result.outputCount > 1) {
+        for (size_t s = 0; s < result.outputSelections.size(); ++s) {
+            std::vector<std::string> functions = outputStrings(result, s, nbVars);
+            text << "Solution " << s + 1 << ":\n";
+            for (size_t o = 0; o < functions.size(); ++o)
+                text << "  F" << o << " = " << functions[o] << "\n";
+        }
+    } else {
+        std::vector<std::string> solutions = solutionStrings(result.primes, result.essential, result.solutions, nbVars);
+        if (solutions.empty()) text << "F = 0\n";
+        for (size_t s = 0; s < solutions.size(); ++s)
+            text << "Solution " << s + 1 << ": F = " << solutions[s] << "\n";
+    }
+    return text.str();
+}
+
 // Inside FileManip.cpp, for the function FileManip::printMinimizedFunction:
 
 void FileManip::printMinimizedFunction(
@@ -160,51 +538,22 @@ void FileManip::printMinimizedFunction(
 ) {
     using namespace std;
     std::string selectedFunc = "";
+    std::vector<std::string> allSolutions = solutionStrings(primes, essential, minimalSolutions, nbVars);
 
     // case1 only epis
     if (minimalSolutions.empty() && !essential.empty()) {
         std::cout << endl << "Minimized Boolean Function (1 Solution, only EPIs):" << endl;
-
-        for (int idx : essential) {
-            selectedFunc += Implicant::patternToBoolean(primes[idx].pattern);
-            selectedFunc += " + ";
-        }
-        // removing trailing +s
-        if (selectedFunc.size() > 3) {
-            selectedFunc.resize(selectedFunc.size() - 3);
-        }
+        selectedFunc = allSolutions[0];
         std::cout << "  F = " << selectedFunc << endl;
 
     }
 
     // cas2 petricks method solutions
     else {
-        std::vector<std::string> allSolutions;
-
-        // Print and store all solutions
+        // Print all solutions
         std::cout << endl << "Minimized Boolean Function (" << minimalSolutions.size() << " Solution(s)):" << endl;
-        for (size_t s = 0; s < minimalSolutions.size(); ++s) {
-            std::string currentFunc = "";
-
-            // 1. Add Essential PIs
-            for (int idx : essential) {
-                currentFunc += Implicant::patternToBoolean(primes[idx].pattern);
-                currentFunc += " + ";
-            }
-
-            // 2. adding the selected non essential PIs
-            for (int idx : minimalSolutions[s]) {
-                currentFunc += Implicant::patternToBoolean(primes[idx].pattern);
-                currentFunc += " + ";
-            }
-
-            // cleaning up trailing +s
-            if (currentFunc.size() > 3) {
-                currentFunc.resize(currentFunc.size() - 3);
-            }
-
-            allSolutions.push_back(currentFunc); // storing the generated string
-            std::cout << "  Solution " << s + 1 << ": F = " << currentFunc << "\n";
+        for (size_t s = 0; s < allSolutions.size(); ++s) {
+            std::cout << "  Solution " << s + 1 << ": F = " << allSolutions[s] << "\n";
         }
 
 
@@ -237,4 +586,52 @@ void FileManip::printMinimizedFunction(
         VerilogConverter::generateVerilogModule(moduleName, selectedFunc, nbVars, moduleName+".txt");
     }
     return;
-}
\ No newline at end of file
+}
+std::vector<std::string> FileManip::outputStrings(const MinimizationResult& result, size_t solution, int nbVars) {
+    std::vector<std::string> functions;
+    for (const std::vector<int>& terms : result.outputSelections[solution]) {
+        std::string currentFunc = "";
+        for (int idx : terms) {
+            if (!currentFunc.empty()) currentFunc += " + ";
+            currentFunc += Implicant::patternToBoolean(result.primes[(size_t)idx].cube.toPattern(nbVars));
+        }
+        functions.push_back(currentFunc.empty() ? "0" : currentFunc);
+    }
+    return functions;
+}
+
+// the multi-output version of printMinimizedFunction: every solution as F0 = ..., F1 = ...
+// (a product term used by several outputs is built once in the Verilog module)
+void FileManip::printMultiOutputFunction(const MinimizationResult& result, int nbVars) {
+    const size_t solutionCount = result.outputSelections.size();
+    cout << endl << "Minimized Boolean Functions (" << result.outputCount << " outputs, "
+         << solutionCount << " Solution(s)):" << endl;
+    for (size_t s = 0; s < solutionCount; ++s) {
+        std::vector<std::string> functions = outputStrings(result, s, nbVars);
+        std::set<int> used;
+        for (const std::vector<int>& terms : result.outputSelections[s]) used.insert(terms.begin(), terms.end());
+        cout << "  Solution " << s + 1 << " (" << used.size() << " distinct product terms):\n";
+        for (size_t o = 0; o < functions.size(); ++o)
+            cout << "    F" << o << " = " << functions[o] << "\n";
+    }
+
+    cout << endl << "Would you like to convert to Verilog code? (Insert 1 for yes): ";
+    int choice;
+    cin >> choice;
+    if (choice != 1) return;
+
+    size_t solution_index = 1;
+    if (solutionCount > 1) {
+        cout << endl << "Which of the solutions would you like to implement? (Enter a number from 1 to " << solutionCount << "): ";
+        cin >> solution_index;
+        if (solution_index < 1 || solution_index > solutionCount) {
+            std::cerr << "\nInvalid choice. Skipping Verilog generation." << std::endl;
+            return;
+        }
+    }
+
+    cout << endl << "Insert the name for the Verilog module: ";
+    string moduleName;
+    cin >> moduleName;
+    VerilogConverter::generateMultiOutputModule(moduleName, outputStrings(result, solution_index - 1, nbVars), nbVars, moduleName+".txt");
+}
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <bitset>
@@ -17,6 +18,8 @@
 #include <set>
 #include <unordered_map>
 
+#include "CoverSolver.h"
+#include "Espresso.h"
 #include "Implicant.h"
 #include "VerliogConverter.h"
 
@@ -25,16 +28,112 @@ using BooleanExpression = std::vector<ProductTerm>;
 
 using namespace std;
 class Implicant; // to fix the forward declaration error
+
+// which minimizer runs
+enum class Engine {
+    Auto,     // exact QM, or the heuristic when the function is too big for it
+    Exact,    // Quine-McCluskey + PI chart (minimum covers, up to 64 variables if the function is sparse)
+    Heuristic, // Espresso-style expand/irredundant/reduce (one good cover, up to 64 variables)
+    Zdd       // exact, with the primes generated implicitly on decision diagrams (see Zdd.h)
+};
+
+// most terms a function file may list (ranges expanded, all lines together): 128 MB of terms,
+// so a range like m0-1099511627775 is an error instead of running the process out of memory
+constexpr size_t kMaxListedTerms = 1 << 24;
+
+// Engine::Auto goes by an estimate of what exact QM will cost: small functions always run exact,
+// bigger ones only while they are sparse, i.e. a listed point has few neighbours (points one
+// variable away) in on-set + don't cares. Random functions with a mean below 2 finish exact in
+// well under a second at any size (3000 terms over 40 variables: 20 ms), past 2.5 the cover
+// solver takes seconds to minutes while the heuristic stays fast. A small space is always exact
+// whatever its density: there the heuristic loses a few cubes (test11: 44 instead of 40).
+constexpr int kAutoExactVars = 10;               // always exact up to this many variables
+constexpr size_t kAutoExactTerms = 128;          // always exact up to this many terms
+constexpr size_t kAutoMaxExactTerms = 1 << 15;   // never past this many (the chart is terms x primes bits)
+constexpr double kAutoExactDegree = 2.0;         // most neighbours per term, on average, for exact
+// A dense function can still pass these (any function up to 10 variables does) and leave a chart
+// the cover solver needs minutes for, so under Engine::Auto its search for the minimum size gets
+// this many nodes (about a second on a random 10-variable chart, test11 needs 242); past them
+// the function goes to the heuristic, with a note.
+constexpr size_t kAutoSearchNodes = 20000;
+
+// settings that come from the command line (see main.cpp)
+struct RunOptions {
+    Engine engine = Engine::Auto;
+    int threads = 0; // size of the thread pool, 0 = one per hardware thread
+    CoverMode coverMode = CoverMode::BranchAndBound; // solver for the non-essential part of the chart
+    size_t petrickMemoryMB = 1024; // ceiling of the tree Petrick's expressions, past it the chart goes to branch and bound
+    bool reduceChart = false; // dominance reduction before the solver (keeps one minimum cover per cost, off = all of them)
+    size_t maxSolutions = 100; // minimum covers listed, the others are only counted in a note (0 = all of them)
+    std::string cacheDir; // directory of the result cache (see ResultCache.h), empty = no cache
+    bool verify = true; // check every solution against the function (see Verifier.h)
+};
+
+// a function as read from a test file, one minterm and one don't care list per output
+// (a plain single-output file has one of each)
+struct BooleanFunction {
+    int nbVars = 0;
+    std::vector<std::vector<Term>> minterms;
+    std::vector<std::vector<Term>> dontCares;
+
+    size_t outputCount() const { return minterms.size(); }
+};
+
+// for each output, the indices into primes it ORs together
+using OutputSelection = std::vector<std::vector<int>>;
+
+// what one minimization produced. primes holds the PIs (exact) or the cover cubes (heuristic);
+// each solution is a set of indices into primes that goes with the essential ones.
+// With several outputs the PIs are shared, and outputSelections has, per solution, which of
+// them each output uses.
+struct MinimizationResult {
+    bool heuristic = false;
+    bool fromCache = false; // read back from the result cache (primes then have no covered lists)
+    size_t outputCount = 1;
+    std::vector<Implicant> primes;
+    std::vector<int> essential;
+    std::vector<Term> remaining; // minterms left after the EPIs (exact only)
+    std::vector<ProductTerm> solutions;
+    std::vector<OutputSelection> outputSelections; // multi-output only
+    std::string verifyError; // set when a solution failed the check (empty when it passed or was off)
+};
+
+class ThreadPool;
+
 // class for any file manipulations such as parsing
 class FileManip {
 public:
-    static std::vector<int> parseTerms(const std::string &line, char expectedPrefix) ;
+    // errors come back in `error` (false return) instead of ending the program, so a batch
+    // run can skip a bad file
+    // at most maxTerms terms once the ranges are expanded, more is an error
+    static bool parseTerms(std::string_view line, char expectedPrefix, Term maxValue, std::vector<Term> &nums, std::string &error,
+                           size_t maxTerms = kMaxListedTerms);
+    static bool loadFunction(const std::string &filePath, BooleanFunction &function, std::string &error);
+    static bool parseFunction(std::string_view text, BooleanFunction &function, std::string &error);
 
-    static string toBinary(int num, int bits);
-    static int doQMmin();
+    static string toBinary(Term num, int bits);
+    static MinimizationResult minimize(const BooleanFunction &function, const RunOptions &options, ThreadPool *pool, bool verbose);
+    // the choice of Engine::Auto (see kAutoExactDegree): true for the exact engine
+    static bool autoPicksExact(const BooleanFunction &function);
+    static MinimizationResult minimizeUncached(const BooleanFunction &function, bool heuristic, const RunOptions &options, ThreadPool *pool, bool verbose);
+    // the two ends of minimizeUncached, also used for PLA input (Pla.h): one Espresso cover per
+    // output as a result, and the chart + cover solver once result.primes is set (false when
+    // Engine::Auto's cover search ran past kAutoSearchNodes; the caller then runs the heuristic)
+    static MinimizationResult heuristicResult(const std::vector<Cover> &covers, int nbVars, bool verbose);
+    static bool solveChart(MinimizationResult &result, const std::vector<std::vector<Term>> &minterms, int nbVars,
+                           const RunOptions &options, ThreadPool *pool, bool verbose);
+    static int doQMmin(const RunOptions& options);
+    static std::vector<std::string> solutionStrings(const std::vector<Implicant> &primes, const std::vector<int> &essential,
+                                                    const std::vector<ProductTerm> &minimalSolutions, int nbVars);
+    // every solution as "Solution k: F = ..." lines (a "Solution k:" line then "  Fo = ..." per
+    // output with several outputs), "F = 0" when there is nothing to print; what --batch writes
+    static std::string resultText(const MinimizationResult &result, int nbVars);
     static void printMinimizedFunction(const std::vector<Implicant> &primes, const std::vector<int> &essential, const std::vector<ProductTerm> &
                                        minimalSolutions, int nbVars
     );
+    // multi-output: solution s as one SOP string per output ("0" for an output with no cube)
+    static std::vector<std::string> outputStrings(const MinimizationResult &result, size_t solution, int nbVars);
+    static void printMultiOutputFunction(const MinimizationResult &result, int nbVars);
 };
 
 
@@ -3,31 +3,33 @@
 //
 
 #include "Implicant.h"
+#include "CubeIndex.h"
+#include "PIChart.h"
+#include "Profile.h"
+#include "ThreadPool.h"
+#include "WidthClass.h"
 
 
 //Function 3: Initial Implicants
 vector<Implicant> Implicant::buildInitialImplicants(int n,
-                                         const vector<int>& minterms,
-                                         const vector<int>& dontCares) {
+                                         const vector<Term>& minterms,
+                                         const vector<Term>& dontCares) {
+    // memory follows the number of terms given, nothing is sized by 2^n
     vector<Implicant> result;
     result.reserve(minterms.size() + dontCares.size());
 
-    //a quick membership test
-    vector<char> isDont((1 << n), 0);
-    for (int d : dontCares) isDont[d] = 1;
-
     //add minterms
-    for (int m : minterms) {
+    for (Term m : minterms) {
         Implicant imp;
-        imp.pattern = FileManip::toBinary(m, n);
+        imp.cube = Cube::fromTerm(m, n);
         imp.covered = { m };
         imp.isPureDontCare = false; // contains a minterm
         result.push_back(std::move(imp));
     }
     //add dont-cares
-    for (int d : dontCares) {
+    for (Term d : dontCares) {
         Implicant imp;
-        imp.pattern = FileManip::toBinary(d, n);
+        imp.cube = Cube::fromTerm(d, n);
         imp.covered = { d };
         imp.isPureDontCare = true; // only dont care
         result.push_back(std::move(imp));
@@ -36,78 +38,618 @@ vector<Implicant> Implicant::buildInitialImplicants(int n,
 }
 
 
+//Function 3b: Initial implicants of a multi-output function. A term listed by several outputs
+// becomes one implicant whose output mask has all of them; it is a pure don't care only if no
+// output has it as a minterm.
+vector<Implicant> Implicant::buildMultiOutputImplicants(int n,
+                                                        const vector<vector<Term>>& minterms,
+                                                        const vector<vector<Term>>& dontCares) {
+    vector<Implicant> result;
+    unordered_map<Term, size_t> position; // term -> index in result
+    auto add = [&](Term t, size_t output, bool dontCare) {
+        auto ins = position.emplace(t, result.size());
+        if (ins.second) {
+            Implicant imp;
+            imp.cube = Cube::fromTerm(t, n);
+            imp.covered = { t };
+            imp.isPureDontCare = dontCare;
+            imp.outputs = 0;
+            result.push_back(std::move(imp));
+        }
+        Implicant& imp = result[ins.first->second];
+        imp.outputs |= 1ULL << output;
+        imp.isPureDontCare = imp.isPureDontCare && dontCare;
+    };
+    for (size_t o = 0; o < minterms.size(); ++o) {
+        for (Term m : minterms[o]) add(m, o, false);
+        if (o < dontCares.size())
+            for (Term d : dontCares[o]) add(d, o, true);
+    }
+    return result;
+}
+
+
 //Function 4: Print implicants
 
-void Implicant::printImplicants(const vector<Implicant>& imps) {
+// "{0,2}" for outputs 0 and 2
+string Implicant::outputsToString(uint64_t outputs) {
+    string text = "{";
+    for (int o = 0; o < 64; ++o) {
+        if (!((outputs >> o) & 1ULL)) continue;
+        if (text.size() > 1) text += ",";
+        text += to_string(o);
+    }
+    return text + "}";
+}
+
+void Implicant::printImplicants(const vector<Implicant>& imps, int n, int outputCount) {
     cout << "\nInitial implicants (" << imps.size() << "):\n";
     for (size_t i=0;i<imps.size();++i) {
-        cout << "  [" << i << "] pattern=" << imps[i].pattern
+        cout << "  [" << i << "] pattern=" << imps[i].cube.toPattern(n)
              << " covered={";
         for (size_t k=0;k<imps[i].covered.size();++k) {
             cout << imps[i].covered[k];
             if (k+1 < imps[i].covered.size()) cout << ",";
         }
-        cout << "} pureDontCare=" << (imps[i].isPureDontCare ? "yes" : "no") << "\n";
+        cout << "} pureDontCare=" << (imps[i].isPureDontCare ? "yes" : "no");
+        if (outputCount > 1) cout << " outputs=" << outputsToString(imps[i].outputs);
+        cout << "\n";
     }
 }
 
-// Function 5: count '1's ignoring '-'
-int Implicant::countOnes(const string& pattern) {
-    return (int)std::count(pattern.begin(), pattern.end(), '1');
+// Function 5: count '1's ignoring '-' (value bits are always 0 under a '-')
+int Implicant::countOnes(const Cube& cube) {
+    return cube.countOnes();
 }
 
 
-// Function 6: attempt combine two patterns
+// Function 6: attempt combine two cubes
 // Rules:
-//  - They must differ in exactly one position where both have 0/1.
-//  - No combination if a differing position contains '-' in either pattern.
-//  - Other positions must be identical (including '-' matches).
-
-bool Implicant::canCombine(const string& a, const string& b, string& outPattern) {
-    if (a.size() != b.size()) return false;
-    int diffCount = 0;
-    size_t diffPos = 0;
-    for (size_t i=0;i<a.size();++i) {
-        char ca = a[i];
-        char cb = b[i];
-        if (ca == cb) continue;
-        // If either is '-', cannot combine on that difference
-        if (ca == '-' || cb == '-') return false;
-        // Must be a 0/1 difference
-        if ((ca == '0' && cb == '1') || (ca == '1' && cb == '0')) {
-            diffCount++;
-            diffPos = i;
-            if (diffCount > 1) return false;
-        } else {
-            // Some unexpected character difference
-            return false;
-        }
-    }
-    if (diffCount == 1) {
-        outPattern = a;
-        outPattern[diffPos] = '-';
-        return true;
-    }
-    return false;
+//  - They must have the same '-' positions (same mask).
+//  - Their values must differ in exactly one position (XOR has a single bit set).
+// The result clears that bit from the mask (and the value keeps 0 there).
+
+bool Implicant::canCombine(const Cube& a, const Cube& b, Cube& out) {
+    if (a.mask != b.mask) return false;
+    uint64_t diff = a.value ^ b.value;
+    if (popcount64(diff) != 1) return false;
+    out.mask = a.mask & ~diff;
+    out.value = a.value & ~diff;
+    return true;
 }
 
 
 //Function 7: Deduplicate & merge coverage
 
-void Implicant::mergeCoverage(vector<int>& target, const vector<int>& add) {
-    // Insert then deduplicate
+void Implicant::mergeCoverage(vector<Term>& target, const vector<Term>& add) {
+    // both lists are kept sorted, so a linear merge is enough (no re-sort)
+    size_t middle = target.size();
     target.insert(target.end(), add.begin(), add.end());
-    sort(target.begin(), target.end());
+    inplace_merge(target.begin(), target.begin() + (ptrdiff_t)middle, target.end());
     target.erase(unique(target.begin(), target.end()), target.end());
 }
 
 
 // Function 8: Generate Prime Implicants
 
+namespace {
+
+// One implicant of a combining pass. Plain data: its coverage is the span
+// [coverBegin, coverBegin + coverCount) of the pass's shared coverage buffer (sorted terms).
+template <int Width>
+struct PassImplicant {
+    FixedCube<Width> cube;
+    uint64_t outputs;
+    size_t coverBegin;
+    size_t coverCount;
+    bool isPureDontCare;
+    bool combined;
+};
+
+// Storage of one pass. Two arenas are used in turn (pass k reads one while pass k+1 is written
+// into the other) and clear() keeps their capacity, so after the first passes no implicant costs
+// an allocation any more, and nothing is copied from one pass to the next.
+template <int Width>
+struct PassArena {
+    vector<PassImplicant<Width>> implicants;
+    vector<Term> coverage;
+
+    void clear() {
+        implicants.clear();
+        coverage.clear();
+    }
+    const Term* coverBegin(const PassImplicant<Width>& imp) const { return coverage.data() + imp.coverBegin; }
+    const Term* coverEnd(const PassImplicant<Width>& imp) const { return coverage.data() + imp.coverBegin + imp.coverCount; }
+
+    // appends the union of two sorted spans (not of this arena) and returns where it starts
+    size_t appendUnion(const Term* a, const Term* aEnd, const Term* b, const Term* bEnd, size_t& count) {
+        size_t begin = coverage.size();
+        coverage.resize(begin + (size_t)(aEnd - a) + (size_t)(bEnd - b));
+        auto last = set_union(a, aEnd, b, bEnd, coverage.begin() + (ptrdiff_t)begin);
+        coverage.erase(last, coverage.end());
+        count = coverage.size() - begin;
+        return begin;
+    }
+
+    // folds other's coverage into target's (both of this arena). Equal spans (the usual case: a
+    // term listed twice) cost nothing, otherwise the union goes to the end of the buffer.
+    void unite(PassImplicant<Width>& target, const PassImplicant<Width>& other) {
+        if (equal(coverBegin(target), coverEnd(target), coverBegin(other), coverEnd(other))) return;
+        coverage.reserve(coverage.size() + target.coverCount + other.coverCount); // spans stay valid
+        target.coverBegin = appendUnion(coverBegin(target), coverEnd(target), coverBegin(other), coverEnd(other),
+                                        target.coverCount);
+    }
+};
+
 // Returns all prime implicants derived from initial implicants.
-vector<Implicant> Implicant::generatePrimeImplicants(const vector<Implicant>& initial, int n) {
+// Each pass hashes every cube of the pass, then for each implicant flips each free 0 bit and
+// probes for the partner cube (same mask, that bit set). A pass costs O(N*n) probes instead of
+// comparing every pair in groups g and g+1. With a pool, the group pairs are spread over its
+// threads; the result is the same as the single-threaded run.
+// The passes live in two PassArenas used in turn; only the primes become Implicants.
+// Instantiated per width class (see WidthClass.h), so the cubes of a pass are two Width-bit words.
+template <int Width>
+vector<Implicant> generatePrimesHashed(const vector<Implicant>& initial, int n, ThreadPool* pool) {
+    using PassCube = FixedCube<Width>;
+    using PassCubeHash = FixedCubeHash<Width>;
+    using Word = typename PassCube::Word;
+    PassArena<Width> arenas[2];
+    PassArena<Width>* current = &arenas[0];
+    PassArena<Width>* next = &arenas[1];
+    size_t initialCoverage = 0;
+    for (const auto& imp : initial) initialCoverage += imp.covered.size();
+    current->implicants.reserve(initial.size());
+    current->coverage.reserve(initialCoverage);
+    for (const auto& imp : initial) {
+        PassImplicant<Width> passImp;
+        passImp.cube = PassCube::from(imp.cube);
+        passImp.outputs = imp.outputs;
+        passImp.coverBegin = current->coverage.size();
+        passImp.coverCount = imp.covered.size();
+        passImp.isPureDontCare = imp.isPureDontCare;
+        passImp.combined = false;
+        current->coverage.insert(current->coverage.end(), imp.covered.begin(), imp.covered.end());
+        current->implicants.push_back(passImp);
+    }
+
+    vector<Implicant> primes;
+    unordered_map<Cube, int, CubeHash> primeIndex; // cube -> index in primes
+
+    // Reused from pass to pass. The cubes made by a pass are already distinct, so the index built
+    // while collecting them is the next pass's passIndex and only the first pass hashes its input.
+    unordered_map<PassCube, int, PassCubeHash> passIndex;
+    unordered_map<PassCube, int, PassCubeHash> newIndex; // new cube -> index in next->implicants
+    vector<char> duplicate;
+    int maxGroupIndex = n; // worst-case
+    std::array<vector<int>, Width + 1> groups; // store indices
+
+    // Split the combining work into tasks: one per group pair (g, g+1), with large groups cut
+    // into chunks so the pool can balance them. Every task fills its own buffer; a made cube only
+    // records the pair it came from, its coverage is written when the buffers are merged.
+    struct CombineTask { int group; size_t begin; size_t end; };
+    struct MadeCube { PassCube cube; int idxA; int idxB; uint64_t outputs; };
+    struct CombineBuffer {
+        vector<MadeCube> made;    // new cubes in the order this task found them
+        vector<int> combinedIdx;  // implicants of `current` that took part in a combination
+        unordered_set<PassCube, PassCubeHash> seen;
+        QM_PROFILE_ONLY(uint64_t attempts = 0; uint64_t successes = 0;)
+    };
+    vector<CombineTask> tasks;
+    vector<CombineBuffer> buffers;
+
+    // Loop passes until no new combinations
+    bool firstPass = true;
+    while (!current->implicants.empty()) {
+        vector<PassImplicant<Width>>& imps = current->implicants;
+        QM_PROFILE_APPEND("combine.implicantsPerPass", imps.size());
+
+        // Hash every cube of the first pass. A repeated cube (e.g. a term listed twice) is folded
+        // into its first occurrence and flagged so it is neither probed nor reported as a prime.
+        duplicate.assign(imps.size(), 0);
+        if (firstPass) {
+            passIndex.reserve(imps.size() * 2);
+            for (size_t i=0;i<imps.size();++i) {
+                auto ins = passIndex.emplace(imps[i].cube, (int)i);
+                if (!ins.second) {
+                    PassImplicant<Width>& first = imps[ins.first->second];
+                    current->unite(first, imps[i]);
+                    first.isPureDontCare = first.isPureDontCare && imps[i].isPureDontCare;
+                    first.outputs |= imps[i].outputs;
+                    duplicate[i] = 1;
+                }
+            }
+            firstPass = false;
+        }
+
+        // Group by count of ones so the next pass comes out in the same group order as before
+        for (auto& group : groups) group.clear();
+        for (size_t i=0;i<imps.size();++i) {
+            if (duplicate[i]) continue;
+            groups[(size_t)imps[i].cube.countOnes()].push_back((int)i);
+        }
+
+        const size_t chunkSize = (pool != nullptr && pool->size() > 1) ? 512 : imps.size() + 1;
+        tasks.clear();
+        for (int g=0; g<maxGroupIndex; ++g) {
+            if (groups[g].empty() || groups[g+1].empty()) continue;
+            for (size_t b = 0; b < groups[g].size(); b += chunkSize)
+                tasks.push_back({g, b, std::min(b + chunkSize, groups[g].size())});
+        }
+        if (buffers.size() < tasks.size()) buffers.resize(tasks.size());
+        for (size_t t = 0; t < tasks.size(); ++t) {
+            buffers[t].made.clear();
+            buffers[t].combinedIdx.clear();
+            buffers[t].seen.clear();
+            QM_PROFILE_ONLY(buffers[t].attempts = 0; buffers[t].successes = 0;)
+        }
+
+        // Combine each implicant of group g with its partners in group g+1
+        auto combineTask = [&](size_t t) {
+            const CombineTask& task = tasks[t];
+            CombineBuffer& out = buffers[t];
+            for (size_t k = task.begin; k < task.end; ++k) {
+                int idxA = groups[task.group][k];
+                const PassCube a = imps[idxA].cube;
+                uint64_t freeZeros = a.mask & ~a.value;
+                while (freeZeros) {
+                    uint64_t bit = freeZeros & (~freeZeros + 1); // lowest free 0 bit
+                    freeZeros &= freeZeros - 1;
+
+                    PassCube partner;
+                    partner.mask = a.mask;
+                    partner.value = (Word)(a.value | bit);
+                    QM_PROFILE_ONLY(++out.attempts;)
+                    auto found = passIndex.find(partner);
+                    if (found == passIndex.end()) continue;
+                    int idxB = found->second;
+                    // the merged cube only belongs to the outputs both halves belong to
+                    uint64_t outputs = imps[idxA].outputs & imps[idxB].outputs;
+                    if (outputs == 0) continue;
+                    QM_PROFILE_ONLY(++out.successes;)
+
+                    // Originals get marked as combined when the buffers are merged, but only when
+                    // the merged cube keeps all of their outputs (otherwise they are still prime
+                    // for the outputs it lost)
+                    if (outputs == imps[idxA].outputs) out.combinedIdx.push_back(idxA);
+                    if (outputs == imps[idxB].outputs) out.combinedIdx.push_back(idxB);
+
+                    PassCube newCube;
+                    newCube.mask = (Word)(a.mask & ~bit);
+                    newCube.value = a.value;
+                    // The same cube is reached once per '-' it has; its coverage and don't-care
+                    // status don't depend on which pair produced it, so only the first one is kept.
+                    if (out.seen.insert(newCube).second)
+                        out.made.push_back({newCube, idxA, idxB, outputs});
+                }
+            }
+        };
+        {
+            QM_PROFILE_TIMER("combine.pairs");
+            if (pool != nullptr) pool->run(tasks.size(), combineTask);
+            else for (size_t t = 0; t < tasks.size(); ++t) combineTask(t);
+        }
+        QM_PROFILE_ONLY(
+            uint64_t attempts = 0, successes = 0;
+            for (size_t t = 0; t < tasks.size(); ++t) {
+                attempts += buffers[t].attempts;
+                successes += buffers[t].successes;
+            }
+            QM_PROFILE_APPEND("combine.attemptsPerPass", attempts);
+            QM_PROFILE_APPEND("combine.successesPerPass", successes);
+        )
+
+        // Merge the buffers in task order and deduplicate once, which gives exactly the
+        // order and content of a single-threaded pass.
+        QM_PROFILE_ONLY(Profile::ScopedTimer mergeTimer("combine.mergeAndPrimeDedup");)
+        next->clear();
+        newIndex.clear();
+        for (size_t t = 0; t < tasks.size(); ++t) {
+            for (int idx : buffers[t].combinedIdx) imps[idx].combined = true;
+            for (const MadeCube& made : buffers[t].made) {
+                if (!newIndex.emplace(made.cube, (int)next->implicants.size()).second) continue;
+                const PassImplicant<Width>& a = imps[made.idxA];
+                const PassImplicant<Width>& b = imps[made.idxB];
+                PassImplicant<Width> newImp;
+                newImp.cube = made.cube;
+                newImp.outputs = made.outputs;
+                newImp.coverBegin = next->appendUnion(current->coverBegin(a), current->coverEnd(a),
+                                                      current->coverBegin(b), current->coverEnd(b), newImp.coverCount);
+                newImp.isPureDontCare = a.isPureDontCare && b.isPureDontCare;
+                newImp.combined = false;
+                next->implicants.push_back(newImp);
+            }
+        }
+
+        // Any implicant not combined in this pass becomes a prime implicant
+        for (size_t i=0;i<imps.size();++i) {
+            const PassImplicant<Width>& imp = imps[i];
+            if (imp.combined || duplicate[i]) continue;
+            // Avoid duplicate prime implicants with same cube & coverage:
+            auto it = primeIndex.find(imp.cube.toCube());
+            if (it == primeIndex.end()) {
+                primeIndex.emplace(imp.cube.toCube(), (int)primes.size());
+                Implicant prime;
+                prime.cube = imp.cube.toCube();
+                prime.covered.assign(current->coverBegin(imp), current->coverEnd(imp));
+                prime.isPureDontCare = imp.isPureDontCare;
+                prime.outputs = imp.outputs;
+                primes.push_back(std::move(prime));
+            } else {
+                Implicant& existing = primes[it->second];
+                Implicant::mergeCoverage(existing.covered, vector<Term>(current->coverBegin(imp), current->coverEnd(imp)));
+                existing.isPureDontCare = existing.isPureDontCare && imp.isPureDontCare;
+                existing.outputs |= imp.outputs;
+            }
+        }
+
+        // Prepare for next pass: swap the arenas, the new cubes' index becomes the probe index
+        std::swap(current, next);
+        std::swap(passIndex, newIndex);
+    }
+
+    return primes;
+}
+
+// Up to 8 variables a cube is two bytes and (mask << 8 | value) numbers every cube of the
+// space, so a pass's cubes are a 64 Kbit bitmap instead of a hash map and the groups are fixed
+// arrays sized by WidthClass::groupCapacity. Everything lives on the stack; the passes and the
+// order of the primes are those of generatePrimesHashed.
+// Only for single-output minterm / don't care lists (buildInitialImplicants): the coverage of a
+// prime is then every listed point it contains, so it is read off the on / care bitmaps at the end.
+bool fitsSmallEngine(const vector<Implicant>& initial, int n) {
+    if (n > 8) return false;
+    for (const Implicant& imp : initial)
+        if (imp.outputs != 1 || imp.cube.mask != Cube::fullMask(n) || imp.covered.size() != 1 ||
+            imp.covered[0] != imp.cube.value)
+            return false;
+    return true;
+}
+
+vector<Implicant> generatePrimesSmall(const vector<Implicant>& initial, int n) {
+    using SmallCube = FixedCube<8>;
+    constexpr size_t kPassCapacity = WidthClass::passCapacity<8>();
+    constexpr std::array<size_t, 10> kGroupOffsets = WidthClass::groupOffsets<8>();
+    using CubeBits = std::array<uint64_t, 65536 / 64>; // bit (mask << 8 | value)
+    struct Pass {
+        std::array<SmallCube, kPassCapacity> cubes;
+        size_t count = 0;
+        CubeBits present{};
+    };
+    auto key = [](const SmallCube& c) { return ((size_t)c.mask << 8) | c.value; };
+    auto test = [&](const CubeBits& bits, const SmallCube& c) { return (bits[key(c) >> 6] >> (key(c) & 63)) & 1ULL; };
+    auto set = [&](CubeBits& bits, const SmallCube& c) { bits[key(c) >> 6] |= 1ULL << (key(c) & 63); };
+
+    std::array<uint64_t, 4> on{}, care{}; // points listed as a minterm / as anything
+    Pass passes[2];
+    Pass* current = &passes[0];
+    Pass* next = &passes[1];
+    for (const Implicant& imp : initial) {
+        const Term t = imp.cube.value;
+        care[t >> 6] |= 1ULL << (t & 63);
+        if (!imp.isPureDontCare) on[t >> 6] |= 1ULL << (t & 63);
+        const SmallCube c = SmallCube::from(imp.cube);
+        if (test(current->present, c)) continue; // a term listed twice keeps its first place
+        set(current->present, c);
+        current->cubes[current->count++] = c;
+    }
+
+    std::array<uint16_t, kGroupOffsets[9]> groups; // group g is groups[kGroupOffsets[g] ..]
+    std::array<size_t, 9> groupSize;
+    CubeBits combined;
+    vector<Implicant> primes;
+    while (current->count != 0) {
+        QM_PROFILE_APPEND("combine.implicantsPerPass", current->count);
+        groupSize.fill(0);
+        for (size_t i = 0; i < current->count; ++i) {
+            const size_t g = (size_t)current->cubes[i].countOnes();
+            groups[kGroupOffsets[g] + groupSize[g]++] = (uint16_t)i;
+        }
+        combined.fill(0);
+        next->count = 0;
+        next->present.fill(0);
+        QM_PROFILE_ONLY(uint64_t attempts = 0, successes = 0;)
+        for (int g = 0; g < n; ++g) {
+            if (groupSize[(size_t)g] == 0 || groupSize[(size_t)g + 1] == 0) continue;
+            for (size_t k = 0; k < groupSize[(size_t)g]; ++k) {
+                const SmallCube a = current->cubes[groups[kGroupOffsets[(size_t)g] + k]];
+                unsigned freeZeros = a.mask & ~a.value & 0xFFu;
+                while (freeZeros) {
+                    const unsigned bit = freeZeros & (~freeZeros + 1); // lowest free 0 bit
+                    freeZeros &= freeZeros - 1;
+                    SmallCube partner = a;
+                    partner.value = (uint8_t)(a.value | bit);
+                    QM_PROFILE_ONLY(++attempts;)
+                    if (!test(current->present, partner)) continue;
+                    QM_PROFILE_ONLY(++successes;)
+                    set(combined, a);
+                    set(combined, partner);
+                    SmallCube made = a;
+                    made.mask = (uint8_t)(a.mask & ~bit);
+                    if (test(next->present, made)) continue;
+                    set(next->present, made);
+                    next->cubes[next->count++] = made;
+                }
+            }
+        }
+        QM_PROFILE_APPEND("combine.attemptsPerPass", attempts);
+        QM_PROFILE_APPEND("combine.successesPerPass", successes);
+
+        for (size_t i = 0; i < current->count; ++i) {
+            const SmallCube c = current->cubes[i];
+            if (test(combined, c)) continue;
+            Implicant prime;
+            prime.cube = c.toCube();
+            prime.isPureDontCare = true;
+            const unsigned freeBits = ~c.mask & (unsigned)Cube::fullMask(n);
+            unsigned sub = 0;
+            do {
+                const Term t = c.value | sub;
+                if ((care[t >> 6] >> (t & 63)) & 1ULL) {
+                    prime.covered.push_back(t);
+                    if ((on[t >> 6] >> (t & 63)) & 1ULL) prime.isPureDontCare = false;
+                }
+                sub = (sub - freeBits) & freeBits; // next subset of the free bits, ascending
+            } while (sub != 0);
+            primes.push_back(std::move(prime));
+        }
+        std::swap(current, next);
+    }
+    return primes;
+}
+
+// Cube lists (a PLA's lines, see Pla.h) mix cubes of every size, and the passes only combine
+// cubes with the same mask: a prime spanning a big input cube and a smaller one would never be
+// made. Those lists go through iterated consensus on the cubes as given instead, in Tison's
+// order (all the consensus on variable x before the next variable, which reaches every prime).
+// The outputs count as one more variable: two intersecting cubes give their intersection for
+// the union of their outputs. A cube inside another one that has all of its outputs is dropped
+// as soon as it shows up, so the cubes left at the end are the primes.
+bool onlyTerms(const vector<Implicant>& initial, int n) {
+    for (const Implicant& imp : initial)
+        if (imp.cube.mask != Cube::fullMask(n)) return false;
+    return true;
+}
+
+vector<Implicant> generatePrimesConsensus(const vector<Implicant>& initial, int n) {
+    struct Entry { Cube cube; uint64_t outputs; };
+    vector<Entry> cubes;
+    // the cubes still alive, by id = position in cubes: absorption and the consensus partners
+    // are lookups in it, not scans over every cube made so far
+    CubeIndex index(n);
+    vector<uint32_t> absorbed, partners;
+    // false when a cube already there absorbs it, otherwise drops the ones it absorbs
+    auto add = [&](const Cube& cube, uint64_t outputs) {
+        if (index.find(cube, CubeIndex::Covering,
+                       [&](uint32_t id) { return (cubes[id].outputs & outputs) == outputs; }))
+            return false;
+        absorbed.clear();
+        index.find(cube, CubeIndex::Inside, [&](uint32_t id) {
+            if ((outputs & cubes[id].outputs) == cubes[id].outputs) absorbed.push_back(id);
+            return false;
+        });
+        for (uint32_t id : absorbed) index.erase(cubes[id].cube, id);
+        index.insert(cube, (uint32_t)cubes.size());
+        cubes.push_back({cube, outputs});
+        QM_PROFILE_ADD("consensus.cubes", 1);
+        return true;
+    };
+    uint64_t allOutputs = 0;
+    for (const Implicant& imp : initial) {
+        add(imp.cube, imp.outputs);
+        allOutputs |= imp.outputs;
+    }
+
+    // the output variable first, until no new cube (a consensus there can feed another one)
+    bool grew = (allOutputs & (allOutputs - 1)) != 0;
+    while (grew) {
+        grew = false;
+        for (uint32_t a = 0; a < cubes.size(); ++a) {
+            if (!index.has(a)) continue;
+            partners.clear();
+            index.find(cubes[a].cube, CubeIndex::Meeting, [&](uint32_t b) {
+                const uint64_t shared = cubes[a].outputs & cubes[b].outputs;
+                if (b > a && shared != cubes[a].outputs && shared != cubes[b].outputs) partners.push_back(b); // else nothing new
+                return false;
+            });
+            for (uint32_t b : partners) {
+                if (!index.has(a)) break;
+                if (!index.has(b)) continue;
+                const Cube x = cubes[a].cube, y = cubes[b].cube;
+                Cube both;
+                both.mask = x.mask | y.mask;
+                both.value = x.value | y.value;
+                if (add(both, cubes[a].outputs | cubes[b].outputs)) grew = true;
+            }
+        }
+    }
+
+    vector<uint32_t> zeros;
+    for (int i = 0; i < n; ++i) {
+        const uint64_t bit = 1ULL << i;
+        // the partners (x = 1) get an index of their own, so the lookups only walk those; the
+        // consensus cubes are free in x, they never join it
+        CubeIndex ones(n);
+        zeros.clear();
+        for (uint32_t k = 0; k < cubes.size(); ++k) {
+            if (!index.has(k) || !(cubes[k].cube.mask & bit)) continue;
+            if (cubes[k].cube.value & bit) ones.insert(cubes[k].cube, k);
+            else zeros.push_back(k);
+        }
+        for (uint32_t a : zeros) {
+            if (!index.has(a)) continue;
+            // the ones that clash with a on x only: those meeting a with x flipped
+            Cube flipped = cubes[a].cube;
+            flipped.value |= bit;
+            partners.clear();
+            ones.find(flipped, CubeIndex::Meeting, [&](uint32_t b) {
+                if (index.has(b) && (cubes[a].outputs & cubes[b].outputs)) partners.push_back(b);
+                return false;
+            });
+            for (uint32_t b : partners) {
+                if (!index.has(a)) break;
+                if (!index.has(b)) continue;
+                const Cube x = cubes[a].cube, y = cubes[b].cube;
+                Cube merged;
+                merged.mask = (x.mask | y.mask) & ~bit;
+                merged.value = (x.value | y.value) & merged.mask;
+                add(merged, cubes[a].outputs & cubes[b].outputs);
+            }
+        }
+    }
+
+    // `covered` stays empty (the chart works from the cubes, as with the ZDD primes)
+    CubeIndex onSet(n);
+    for (size_t k = 0; k < initial.size(); ++k)
+        if (!initial[k].isPureDontCare) onSet.insert(initial[k].cube, (uint32_t)k);
+    vector<Implicant> primes;
+    for (uint32_t k = 0; k < cubes.size(); ++k) {
+        if (!index.has(k)) continue;
+        Implicant prime;
+        prime.cube = cubes[k].cube;
+        prime.outputs = cubes[k].outputs;
+        // unless it meets an on-set cube (of any output, like the terms)
+        prime.isPureDontCare = !onSet.find(prime.cube, CubeIndex::Meeting, [](uint32_t) { return true; });
+        primes.push_back(std::move(prime));
+    }
+    // smallest cubes first, like the passes list them
+    sort(primes.begin(), primes.end(), [](const Implicant& a, const Implicant& b) {
+        if (a.cube.mask != b.cube.mask) return popcount64(a.cube.mask) != popcount64(b.cube.mask)
+                                                   ? popcount64(a.cube.mask) > popcount64(b.cube.mask)
+                                                   : a.cube.mask < b.cube.mask;
+        return a.cube.value < b.cube.value;
+    });
+    return primes;
+}
+
+} // namespace
+
+// Picks the engine: iterated consensus for lists of cubes that aren't all terms (PLA input),
+// otherwise by the width class of n: the stack-only one up to 8 variables (single-output minterm
+// lists), or the hashed passes on cubes of 8/16/32/64-bit words.
+vector<Implicant> Implicant::generatePrimeImplicants(const vector<Implicant>& initial, int n, ThreadPool* pool) {
+    QM_PROFILE_TIMER("generatePrimeImplicants");
+    vector<Implicant> primes;
+    if (!onlyTerms(initial, n)) {
+        primes = generatePrimesConsensus(initial, n);
+    } else if (fitsSmallEngine(initial, n)) {
+        primes = generatePrimesSmall(initial, n);
+    } else {
+        primes = WidthClass::dispatch(n, [&](auto width) {
+            return generatePrimesHashed<decltype(width)::value>(initial, n, pool);
+        });
+    }
+    QM_PROFILE_ADD("primes", primes.size());
+    return primes;
+}
+
+// Function 8b: reference version of Function 8 that compares every implicant of group g with
+// every implicant of group g+1. Kept for benchmarking and cross-checking the hashed passes.
+// The pair test runs on a whole group at once (CombineKernel), only the matches are combined.
+vector<Implicant> Implicant::generatePrimeImplicantsGroupScan(const vector<Implicant>& initial, int n, SimdLevel level) {
     vector<Implicant> current = initial;
     vector<Implicant> primes;
+    CubeGroup nextGroup;
+    vector<uint64_t> matches;
 
     // Loop passes until no new combinations
     while (!current.empty()) {
@@ -115,12 +657,12 @@ vector<Implicant> Implicant::generatePrimeImplicants(const vector<Implicant>& in
         int maxGroupIndex = n; // worst-case
         vector<vector<int>> groups(maxGroupIndex + 1); // store indices
         for (size_t i=0;i<current.size();++i) {
-            int ones = countOnes(current[i].pattern);
+            int ones = countOnes(current[i].cube);
             groups[ones].push_back((int)i);
         }
 
-        // Map new pattern -> index in next vector
-        unordered_map<string, int> newIndex;
+        // Map new cube -> index in next vector
+        unordered_map<Cube, int, CubeHash> newIndex;
         vector<Implicant> nextPass;
 
         // Reset combined flags for this pass
@@ -131,32 +673,40 @@ vector<Implicant> Implicant::generatePrimeImplicants(const vector<Implicant>& in
         // Combine adjacent groups
         for (int g=0; g<maxGroupIndex; ++g) {
             if (groups[g].empty() || groups[g+1].empty()) continue;
+            nextGroup.clear();
+            for (int idxB : groups[g+1]) nextGroup.push(current[idxB].cube);
             for (int idxA : groups[g]) {
-                for (int idxB : groups[g+1]) {
-                    string newPattern;
-                    if (canCombine(current[idxA].pattern, current[idxB].pattern, newPattern)) {
-                        // Mark originals as combined
-                        current[idxA].combined = true;
-                        current[idxB].combined = true;
-
-                        auto it = newIndex.find(newPattern);
-                        if (it == newIndex.end()) {
-                            Implicant newImp;
-                            newImp.pattern = newPattern;
-                            newImp.covered = current[idxA].covered;
-                            mergeCoverage(newImp.covered, current[idxB].covered);
-                            newImp.isPureDontCare = current[idxA].isPureDontCare && current[idxB].isPureDontCare;
-                            newImp.combined = false;
-                            int newPos = (int)nextPass.size();
-                            nextPass.push_back(std::move(newImp));
-                            newIndex[newPattern] = newPos;
-                        } else {
-                            // Merge coverage with existing implicant having same pattern
-                            mergeCoverage(nextPass[it->second].covered, current[idxA].covered);
-                            mergeCoverage(nextPass[it->second].covered, current[idxB].covered);
-                            nextPass[it->second].isPureDontCare = nextPass[it->second].isPureDontCare &&
-                                                                  current[idxA].isPureDontCare &&
-                                                                  current[idxB].isPureDontCare;
+                CombineKernel::match(current[idxA].cube, nextGroup, matches, level);
+                for (size_t w = 0; w < matches.size(); ++w) {
+                    for (uint64_t bits = matches[w]; bits != 0; bits &= bits - 1) {
+                        const int idxB = groups[g+1][w * 64 + (size_t)__builtin_ctzll(bits)];
+                        Cube newCube;
+                        uint64_t outputs = current[idxA].outputs & current[idxB].outputs;
+                        if (outputs != 0 && canCombine(current[idxA].cube, current[idxB].cube, newCube)) {
+                            // Mark originals as combined (if the new cube keeps all their outputs)
+                            if (outputs == current[idxA].outputs) current[idxA].combined = true;
+                            if (outputs == current[idxB].outputs) current[idxB].combined = true;
+
+                            auto it = newIndex.find(newCube);
+                            if (it == newIndex.end()) {
+                                Implicant newImp;
+                                newImp.cube = newCube;
+                                newImp.covered = current[idxA].covered;
+                                mergeCoverage(newImp.covered, current[idxB].covered);
+                                newImp.isPureDontCare = current[idxA].isPureDontCare && current[idxB].isPureDontCare;
+                                newImp.combined = false;
+                                newImp.outputs = outputs;
+                                int newPos = (int)nextPass.size();
+                                nextPass.push_back(std::move(newImp));
+                                newIndex[newCube] = newPos;
+                            } else {
+                                // Merge coverage with existing implicant having same pattern
+                                mergeCoverage(nextPass[it->second].covered, current[idxA].covered);
+                                mergeCoverage(nextPass[it->second].covered, current[idxB].covered);
+                                nextPass[it->second].isPureDontCare = nextPass[it->second].isPureDontCare &&
+                                                                      current[idxA].isPureDontCare &&
+                                                                      current[idxB].isPureDontCare;
+                            }
                         }
                     }
                 }
@@ -166,14 +716,15 @@ vector<Implicant> Implicant::generatePrimeImplicants(const vector<Implicant>& in
         // Any implicant not combined in this pass becomes a prime implicant
         for (auto& imp : current) {
             if (!imp.combined) {
-                // Avoid duplicate prime implicants with same pattern & coverage:
+                // Avoid duplicate prime implicants with same cube & coverage:
                 auto it = find_if(primes.begin(), primes.end(),
-                                  [&](const Implicant& p){ return p.pattern == imp.pattern; });
+                                  [&](const Implicant& p){ return p.cube == imp.cube; });
                 if (it == primes.end()) {
                     primes.push_back(imp);
                 } else {
                     mergeCoverage(it->covered, imp.covered);
                     it->isPureDontCare = it->isPureDontCare && imp.isPureDontCare;
+                    it->outputs |= imp.outputs;
                 }
             }
         }
@@ -189,23 +740,24 @@ vector<Implicant> Implicant::generatePrimeImplicants(const vector<Implicant>& in
 // Function 9: Printing helpers
 
 
-void Implicant::printPrimeImplicants(const vector<Implicant>& primes,
-                          const unordered_set<int>& mintermSet,
-                          const unordered_set<int>& dontCareSet) {
+void Implicant::printPrimeImplicants(const vector<Implicant>& primes, int n,
+                          const unordered_set<Term>& mintermSet,
+                          const unordered_set<Term>& dontCareSet,
+                          int outputCount) {
     cout << "\nPrime Implicants (" << primes.size() << "):\n";
     for (size_t i=0;i<primes.size();++i) {
         const auto& imp = primes[i];
         // Separate coverage into minterms and dont-cares for clarity
-        vector<int> mins;
-        vector<int> dcs;
-        for (int v : imp.covered) {
+        vector<Term> mins;
+        vector<Term> dcs;
+        for (Term v : imp.covered) {
             if (mintermSet.count(v)) mins.push_back(v);
             else if (dontCareSet.count(v)) dcs.push_back(v);
         }
         sort(mins.begin(), mins.end());
         sort(dcs.begin(), dcs.end());
 
-        cout << "  PI[" << i << "] pattern=" << imp.pattern << "  covers minterms={";
+        cout << "  PI[" << i << "] pattern=" << imp.cube.toPattern(n) << "  covers minterms={";
         for (size_t k=0;k<mins.size();++k) {
             cout << mins[k];
             if (k+1<mins.size()) cout << ",";
@@ -215,65 +767,41 @@ void Implicant::printPrimeImplicants(const vector<Implicant>& primes,
             cout << dcs[k];
             if (k+1<dcs.size()) cout << ",";
         }
-        cout << "}\n";
+        cout << "}";
+        if (outputCount > 1) cout << " outputs=" << outputsToString(imp.outputs);
+        cout << "\n";
     }
 }
-// Function 10: Build, for each PI, the list of minterms (exclude don’t cares)
-vector<vector<int>> Implicant::buildPICoversMinterm(const vector<Implicant>& primes,
-                                         const unordered_set<int>& mintermSet) {
-    vector<vector<int>> piCovers(primes.size());
-    for (size_t i=0;i<primes.size();++i) {
-        for (int v : primes[i].covered)
-            if (mintermSet.count(v))
-                piCovers[i].push_back(v);
-        sort(piCovers[i].begin(), piCovers[i].end());
-        piCovers[i].erase(unique(piCovers[i].begin(), piCovers[i].end()), piCovers[i].end());
-    }
-    return piCovers;
-}
-
-// Function 11: Implicant::Map each minterm -> list of PI indices that cover it
-unordered_map<int, vector<int>> Implicant::buildMintermToPIs(const vector<vector<int>>& piCovers) {
-    unordered_map<int, vector<int>> m2p;
-    for (int i=0;i<(int)piCovers.size();++i)
-        for (int m : piCovers[i])
-            m2p[m].push_back(i);
-    return m2p;
-}
-
-//Dunction 12:  Find essential PIs: a PI is essential if it is the sole cover for some minterm
-vector<int> Implicant::findEssentialPIs(const vector<Implicant>& primes,
-                             const vector<int>& minterms) {
-    unordered_set<int> mintermSet(minterms.begin(), minterms.end());
-    auto piCovers = buildPICoversMinterm(primes, mintermSet);
-    auto m2p = buildMintermToPIs(piCovers);
-
+//Function 10: Find essential PIs: a PI is essential if it is the sole cover for some minterm,
+// i.e. the column of that minterm has a single row in the chart
+vector<int> Implicant::findEssentialPIs(const PIChart& chart) {
+    QM_PROFILE_TIMER("findEssentialPIs");
     vector<int> essential;
-    for (int m : minterms) {
-        auto it = m2p.find(m);
-        if (it == m2p.end() || it->second.empty()) {
-            cerr << "Error: no PI covers minterm " << m << "\n";
+    for (size_t c = 0; c < chart.columnCount; ++c) {
+        int count = chart.rowsCovering(c);
+        if (count == 0) {
+            cerr << "Error: no PI covers minterm " << chart.columnMinterms[c] << "\n";
             continue;
         }
-        if (it->second.size() == 1)
-            essential.push_back(it->second.front());
+        if (count == 1)
+            essential.push_back(chart.columnRows[(size_t)chart.columnStart[c]]);
     }
     sort(essential.begin(), essential.end());
     essential.erase(unique(essential.begin(), essential.end()), essential.end());
     return essential;
 }
 //Function 13: Printing helper
-void Implicant::printEssentialPIs(const vector<Implicant>& primes,
+void Implicant::printEssentialPIs(const vector<Implicant>& primes, int n,
                        const vector<int>& essential,
-                       const unordered_set<int>& mintermSet) {
+                       const unordered_set<Term>& mintermSet) {
     cout << "\nEssential Prime Implicants (" << essential.size() << "):\n";
     for (int idx : essential) {
-        vector<int> mins;
-        for (int v : primes[idx].covered)
+        vector<Term> mins;
+        for (Term v : primes[idx].covered)
             if (mintermSet.count(v))
                 mins.push_back(v);
         sort(mins.begin(), mins.end());
-        cout << "  EPI[" << idx << "] pattern=" << primes[idx].pattern << " covers minterms={";
+        cout << "  EPI[" << idx << "] pattern=" << primes[idx].cube.toPattern(n) << " covers minterms={";
         for (size_t k=0;k<mins.size();++k) {
             cout << mins[k];
             if (k+1<mins.size()) cout << ",";
@@ -282,18 +810,11 @@ void Implicant::printEssentialPIs(const vector<Implicant>& primes,
     }
 }
 
-//Function 14: Compute minterms still uncovered after taking EPIs
-vector<int> Implicant::remainingMintermsAfterEPIs(const vector<Implicant>& primes,
-                                       const vector<int>& essential,
-                                       const vector<int>& minterms) {
-    unordered_set<int> covered;
-    for (int idx : essential)
-        for (int v : primes[idx].covered)
-            covered.insert(v);
-    vector<int> remain;
-    for (int m : minterms)
-        if (!covered.count(m))
-            remain.push_back(m);
+//Function 14: Compute minterms still uncovered after taking EPIs (OR of the EPI rows)
+vector<Term> Implicant::remainingMintermsAfterEPIs(const PIChart& chart, const vector<int>& essential) {
+    vector<Term> remain;
+    for (int c : chart.uncoveredColumns(essential))
+        remain.push_back(chart.columnMinterms[(size_t)c]);
     return remain;
 }
 
@@ -303,15 +824,15 @@ std::string Implicant::patternToBoolean(const std::string& pattern) {
         return "1"; // hardcode the result for the universal term (test3)
     }
     std::stringstream ss;
-    char var = 'A';
-    for (char c : pattern) {
-        if (c == '0') {
-            ss << var << "'";
-        } else if (c == '1') {
-            ss << var;
+    int nbVars = (int)pattern.size();
+    for (int i = 0; i < nbVars; ++i) {
+        // A, B, C... (x0, x1... past 26 variables)
+        if (pattern[i] == '0') {
+            ss << VerilogConverter::variableName(i, nbVars) << "'";
+        } else if (pattern[i] == '1') {
+            ss << VerilogConverter::variableName(i, nbVars);
         }
         // '-' is ignored
-        var++;
     }
     return ss.str();
 }
\ No newline at end of file
@@ -17,42 +17,54 @@ using namespace std;
 #include <unordered_set>
 #include <unordered_map>
 
+#include "CombineKernel.h"
+#include "Cube.h"
 #include "FileManip.h"
 
+class ThreadPool;
+class PIChart;
+
 //nadine: I created a structure specifically for the implicants to cover all their data
 class Implicant {
 public:
-    string pattern;
-    vector<int> covered;
+    Cube cube; // packed pattern, use cube.toPattern(n) for the '0'/'1'/'-' form
+    vector<Term> covered;
     bool isPureDontCare;
     bool combined = false;
+    uint64_t outputs = 1; // bit o set when the cube lies inside output o's on-set + don't cares
 
     //functions:
 
 
-    static vector<Implicant> buildInitialImplicants(int n, const vector<int>& minterms, const vector<int>& dontCares);
+    static vector<Implicant> buildInitialImplicants(int n, const vector<Term>& minterms, const vector<Term>& dontCares);
+
+    // one implicant per distinct term over all outputs, tagged with the outputs that have it
+    static vector<Implicant> buildMultiOutputImplicants(int n, const vector<vector<Term>>& minterms, const vector<vector<Term>>& dontCares);
 
-    static void printImplicants(const vector<Implicant>& imps);
+    static void printImplicants(const vector<Implicant>& imps, int n, int outputCount = 1);
 
-    static int countOnes(const string& pattern);
+    static int countOnes(const Cube& cube);
 
-    static bool canCombine(const string& a, const string& b, string& outPattern);
+    static bool canCombine(const Cube& a, const Cube& b, Cube& out);
 
-    static void mergeCoverage(vector<int>& target, const vector<int>& add);
+    static void mergeCoverage(vector<Term>& target, const vector<Term>& add);
 
-    static vector<Implicant> generatePrimeImplicants(const vector<Implicant>& initial, int n);
+    // initial: terms (the two builders above) or cubes of any size, e.g. a PLA's lines (Pla.h)
+    static vector<Implicant> generatePrimeImplicants(const vector<Implicant>& initial, int n, ThreadPool* pool = nullptr);
 
-    static void printPrimeImplicants(const vector<Implicant>& primes,const unordered_set<int>& mintermSet,const unordered_set<int>& dontCareSet);
+    // level picks the combine kernel version (the CPU's best by default)
+    static vector<Implicant> generatePrimeImplicantsGroupScan(const vector<Implicant>& initial, int n,
+                                                              SimdLevel level = CombineKernel::detect());
 
-    static vector<vector<int>> buildPICoversMinterm(const vector<Implicant>& primes,const unordered_set<int>& mintermSet);
+    static void printPrimeImplicants(const vector<Implicant>& primes, int n, const unordered_set<Term>& mintermSet,const unordered_set<Term>& dontCareSet, int outputCount = 1);
 
-    static unordered_map<int, vector<int>> buildMintermToPIs(const vector<vector<int>>& piCovers);
+    static string outputsToString(uint64_t outputs);
 
-    static vector<int> findEssentialPIs(const vector<Implicant>& primes,const vector<int>& minterms);
+    static vector<int> findEssentialPIs(const PIChart& chart);
 
-    static void printEssentialPIs(const vector<Implicant>& primes, const vector<int>& essential,const unordered_set<int>& mintermSet);
+    static void printEssentialPIs(const vector<Implicant>& primes, int n, const vector<int>& essential,const unordered_set<Term>& mintermSet);
 
-    static vector<int> remainingMintermsAfterEPIs(const vector<Implicant>& primes,const vector<int>& essential, const vector<int>& minterms);
+    static vector<Term> remainingMintermsAfterEPIs(const PIChart& chart, const vector<int>& essential);
 
     static string patternToBoolean(const std::string& pattern);
 
@@ -0,0 +1,319 @@
+//
+// Stateful exact minimizer for one output that is edited a point at a time.
+//
+
+#include "IncrementalMinimizer.h"
+
+#include "PIChart.h"
+#include "PItable.h"
+
+namespace {
+
+bool cubeLess(const Cube& a, const Cube& b) {
+    return a.mask != b.mask ? a.mask < b.mask : a.value < b.value;
+}
+
+} // namespace
+
+IncrementalMinimizer::IncrementalMinimizer(int nbVars) : n(nbVars), universe(Cube::fullMask(nbVars)) {}
+
+IncrementalMinimizer::IncrementalMinimizer(const BooleanFunction& function)
+    : n(function.nbVars), universe(Cube::fullMask(function.nbVars)) {
+    if (function.outputCount() == 0) return;
+    onSet.insert(function.minterms[0].begin(), function.minterms[0].end());
+    for (Term d : function.dontCares[0])
+        if (!onSet.count(d)) dcSet.insert(d); // a term listed as both is a minterm
+    // the first primes come from the combining passes, every later change is local
+    const vector<Term> on(onSet.begin(), onSet.end());
+    const vector<Term> dc(dcSet.begin(), dcSet.end());
+    for (const Implicant& prime : Implicant::generatePrimeImplicants(Implicant::buildInitialImplicants(n, on, dc), n))
+        addPrime(prime.cube);
+    resolve({}, on);
+}
+
+bool IncrementalMinimizer::fits(Term term) const {
+    if ((term & ~universe) == 0) return true;
+    cerr << "Error: term " << term << " does not fit in " << n << " variables.\n";
+    return false;
+}
+
+bool IncrementalMinimizer::addMinterm(Term term) {
+    if (!fits(term)) return false;
+    stats = IncrementalStats();
+    if (onSet.count(term)) return true;
+    vector<int> touched;
+    vector<Term> seeds{term};
+    if (dcSet.erase(term)) {
+        // on + dc stays the same, only the chart gets a column
+        onSet.insert(term);
+        addColumn(term);
+    } else {
+        onSet.insert(term);
+        grow(term, touched, seeds);
+    }
+    resolve(touched, seeds);
+    return true;
+}
+
+bool IncrementalMinimizer::removeMinterm(Term term) {
+    if (!fits(term)) return false;
+    stats = IncrementalStats();
+    vector<int> touched;
+    vector<Term> seeds;
+    if (onSet.count(term)) removeColumn(term, touched);
+    else if (!dcSet.count(term)) return true;
+    shrink(term, touched, seeds);
+    resolve(touched, seeds);
+    return true;
+}
+
+bool IncrementalMinimizer::setDontCare(Term term) {
+    if (!fits(term)) return false;
+    stats = IncrementalStats();
+    if (dcSet.count(term)) return true;
+    vector<int> touched;
+    vector<Term> seeds;
+    if (onSet.count(term)) {
+        // on + dc stays the same, the chart loses a column
+        removeColumn(term, touched);
+        onSet.erase(term);
+        dcSet.insert(term);
+    } else {
+        dcSet.insert(term);
+        grow(term, touched, seeds);
+    }
+    resolve(touched, seeds);
+    return true;
+}
+
+vector<Term> IncrementalMinimizer::minterms() const {
+    vector<Term> terms(onSet.begin(), onSet.end());
+    sort(terms.begin(), terms.end());
+    return terms;
+}
+
+vector<Term> IncrementalMinimizer::dontCares() const {
+    vector<Term> terms(dcSet.begin(), dcSet.end());
+    sort(terms.begin(), terms.end());
+    return terms;
+}
+
+vector<Cube> IncrementalMinimizer::primes() const {
+    vector<Cube> cubes;
+    for (size_t id = 0; id < primeCubes.size(); ++id)
+        if (alive[id]) cubes.push_back(primeCubes[id]);
+    sort(cubes.begin(), cubes.end(), cubeLess);
+    return cubes;
+}
+
+vector<Cube> IncrementalMinimizer::cover() const {
+    vector<Cube> cubes;
+    for (size_t id = 0; id < primeCubes.size(); ++id)
+        if (alive[id] && selected[id]) cubes.push_back(primeCubes[id]);
+    sort(cubes.begin(), cubes.end(), cubeLess);
+    return cubes;
+}
+
+// every point of the cube is in on + dc: split on the lowest '-' until only points are left,
+// remembering the sub-cubes (the growing / shrinking steps ask about overlapping ones)
+bool IncrementalMinimizer::isImplicant(const Cube& cube) {
+    const uint64_t freeBits = ~cube.mask & universe;
+    if (freeBits == 0) return inFunction(cube.value);
+    auto memo = implicantMemo.find(cube);
+    if (memo != implicantMemo.end()) return memo->second;
+    const uint64_t bit = freeBits & (~freeBits + 1);
+    Cube low{cube.mask | bit, cube.value};
+    Cube high{cube.mask | bit, cube.value | bit};
+    bool result = isImplicant(low) && isImplicant(high);
+    implicantMemo.emplace(cube, result);
+    return result;
+}
+
+// Every prime that contains the point: the implicants around the point grown one '-' at a time
+// (a cube can free a literal when the cube on the other side of it is an implicant too), the
+// ones that can't grow any more are prime. Each level is deduplicated like a combining pass.
+vector<Cube> IncrementalMinimizer::primesContaining(Term point) {
+    vector<Cube> result;
+    if (!inFunction(point)) return result;
+    vector<Cube> level{Cube{universe, point}};
+    unordered_set<Cube, CubeHash> seen;
+    while (!level.empty()) {
+        vector<Cube> next;
+        for (const Cube& cube : level) {
+            bool grew = false;
+            for (uint64_t fixed = cube.mask & universe; fixed; fixed &= fixed - 1) {
+                const uint64_t bit = fixed & (~fixed + 1);
+                if (!isImplicant(Cube{cube.mask, cube.value ^ bit})) continue;
+                grew = true;
+                Cube bigger{cube.mask & ~bit, cube.value & ~bit};
+                if (seen.insert(bigger).second) next.push_back(bigger);
+            }
+            if (!grew) result.push_back(cube);
+        }
+        level = std::move(next);
+    }
+    return result;
+}
+
+int IncrementalMinimizer::addPrime(const Cube& cube) {
+    int id;
+    if (!freeSlots.empty()) {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        id = (int)primeCubes.size();
+        primeCubes.emplace_back();
+        alive.push_back(0);
+        selected.push_back(0);
+        primeMinterms.emplace_back();
+    }
+    primeCubes[(size_t)id] = cube;
+    alive[(size_t)id] = 1;
+    selected[(size_t)id] = 0;
+    vector<Term>& row = primeMinterms[(size_t)id];
+    row.clear();
+    // walk the cube's points when there are fewer of them than minterms, else test the minterms
+    const uint64_t freeBits = ~cube.mask & universe;
+    const int freeCount = popcount64(freeBits);
+    if (freeCount < 32 && (1ULL << freeCount) <= onSet.size()) {
+        uint64_t sub = 0;
+        do {
+            if (onSet.count(cube.value | sub)) row.push_back(cube.value | sub);
+            sub = (sub - freeBits) & freeBits; // next subset of the free bits
+        } while (sub != 0);
+    } else {
+        for (Term m : onSet)
+            if (cube.contains(m)) row.push_back(m);
+    }
+    for (Term m : row) columnPrimes[m].push_back(id);
+    primeIndex.emplace(cube, id);
+    ++stats.primesAdded;
+    return id;
+}
+
+void IncrementalMinimizer::removePrime(int id) {
+    for (Term m : primeMinterms[(size_t)id]) {
+        vector<int>& column = columnPrimes[m];
+        column.erase(find(column.begin(), column.end(), id));
+    }
+    primeMinterms[(size_t)id].clear();
+    primeIndex.erase(primeCubes[(size_t)id]);
+    alive[(size_t)id] = 0;
+    selected[(size_t)id] = 0;
+    freeSlots.push_back(id);
+    ++stats.primesRemoved;
+}
+
+// the point was a don't care: the primes stay, the ones containing it get it in their row
+void IncrementalMinimizer::addColumn(Term minterm) {
+    vector<int>& column = columnPrimes[minterm];
+    for (const Cube& cube : primesContaining(minterm)) {
+        int id = primeIndex.at(cube);
+        column.push_back(id);
+        primeMinterms[(size_t)id].push_back(minterm);
+    }
+}
+
+void IncrementalMinimizer::removeColumn(Term minterm, vector<int>& touched) {
+    auto column = columnPrimes.find(minterm);
+    if (column == columnPrimes.end()) return;
+    for (int id : column->second) {
+        vector<Term>& row = primeMinterms[(size_t)id];
+        row.erase(find(row.begin(), row.end(), minterm));
+        touched.push_back(id);
+    }
+    columnPrimes.erase(column);
+}
+
+// The point is already in on + dc. A new prime has to contain it. An old prime c stops being
+// prime when c + c' (c' = c with one literal flipped) became an implicant, i.e. c' has the
+// point; then c is the half of some new prime on the far side of the point, so checking those
+// halves finds all of them.
+void IncrementalMinimizer::grow(Term point, vector<int>& touched, vector<Term>& seeds) {
+    implicantMemo.clear();
+    const vector<Cube> created = primesContaining(point);
+    for (const Cube& prime : created) {
+        for (uint64_t freeBits = ~prime.mask & universe; freeBits; freeBits &= freeBits - 1) {
+            const uint64_t bit = freeBits & (~freeBits + 1);
+            auto old = primeIndex.find(Cube{prime.mask | bit, prime.value | (~point & bit)});
+            if (old == primeIndex.end()) continue;
+            seeds.insert(seeds.end(), primeMinterms[(size_t)old->second].begin(), primeMinterms[(size_t)old->second].end());
+            removePrime(old->second);
+        }
+    }
+    for (const Cube& prime : created) touched.push_back(addPrime(prime));
+}
+
+// The point leaves on + dc (its column, if any, is already gone). Primes without it stay prime.
+// A prime of the new function inside a dying prime c, without the point, lies in one of c's
+// halves away from the point (a '-' of c fixed to the other value); those halves are
+// implicants, so the new primes are the halves that can't be expanded.
+void IncrementalMinimizer::shrink(Term point, vector<int>& touched, vector<Term>& seeds) {
+    implicantMemo.clear();
+    const vector<Cube> dying = primesContaining(point);
+    onSet.erase(point);
+    dcSet.erase(point);
+    implicantMemo.clear();
+
+    vector<Cube> candidates;
+    for (const Cube& prime : dying) {
+        int id = primeIndex.at(prime);
+        seeds.insert(seeds.end(), primeMinterms[(size_t)id].begin(), primeMinterms[(size_t)id].end());
+        removePrime(id);
+        for (uint64_t freeBits = ~prime.mask & universe; freeBits; freeBits &= freeBits - 1) {
+            const uint64_t bit = freeBits & (~freeBits + 1);
+            candidates.push_back(Cube{prime.mask | bit, prime.value | (~point & bit)});
+        }
+    }
+    for (const Cube& cube : candidates) {
+        if (primeIndex.count(cube)) continue; // already added from another dying prime
+        bool expands = false;
+        for (uint64_t fixed = cube.mask & universe; fixed && !expands; fixed &= fixed - 1)
+            expands = isImplicant(Cube{cube.mask, cube.value ^ (fixed & (~fixed + 1))});
+        if (!expands) touched.push_back(addPrime(cube));
+    }
+}
+
+// Collects the connected part of the chart around the changes (minterm -> its primes -> their
+// minterms ...), drops its old picks and solves it like the full pipeline does.
+void IncrementalMinimizer::resolve(const vector<int>& touched, const vector<Term>& seeds) {
+    unordered_set<Term> seenMinterms;
+    unordered_set<int> seenPrimes;
+    vector<Term> queue;
+    vector<int> rows;
+    auto visitPrime = [&](int id) {
+        if (!alive[(size_t)id] || !seenPrimes.insert(id).second) return;
+        rows.push_back(id);
+        for (Term m : primeMinterms[(size_t)id])
+            if (seenMinterms.insert(m).second) queue.push_back(m);
+    };
+    for (int id : touched) {
+        selected[(size_t)id] = 0; // a pick that lost its minterms goes too
+        visitPrime(id);
+    }
+    for (Term m : seeds)
+        if (onSet.count(m) && seenMinterms.insert(m).second) queue.push_back(m);
+    for (size_t i = 0; i < queue.size(); ++i) {
+        auto column = columnPrimes.find(queue[i]);
+        if (column == columnPrimes.end()) continue;
+        for (int id : column->second) visitPrime(id);
+    }
+    stats.primesSolved = rows.size();
+    stats.columnsSolved = queue.size();
+    for (int id : rows) selected[(size_t)id] = 0;
+    if (queue.empty()) return;
+
+    vector<Implicant> part(rows.size());
+    for (size_t r = 0; r < rows.size(); ++r) {
+        part[r].cube = primeCubes[(size_t)rows[r]];
+        part[r].isPureDontCare = false;
+    }
+    PIChart chart = PIChart::build(part, queue);
+    vector<int> essential = Implicant::findEssentialPIs(chart);
+    vector<int> remaining = chart.uncoveredColumns(essential);
+    vector<ProductTerm> solutions = PItable::solvePIMatrixAndMinimize(part, chart, essential, remaining,
+                                                                      CoverMode::BranchAndBound, true, 1);
+    for (int r : essential) selected[(size_t)rows[(size_t)r]] = 1;
+    if (!solutions.empty())
+        for (int r : solutions[0]) selected[(size_t)rows[(size_t)r]] = 1;
+}
@@ -0,0 +1,90 @@
+//
+// Stateful exact minimizer for one output that is edited a point at a time.
+//
+
+#ifndef QM_DD1_INCREMENTALMINIMIZER_H
+#define QM_DD1_INCREMENTALMINIMIZER_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FileManip.h"
+
+// what the last edit touched
+struct IncrementalStats {
+    size_t primesAdded = 0;
+    size_t primesRemoved = 0;
+    size_t primesSolved = 0;  // rows of the chart part that was solved again
+    size_t columnsSolved = 0; // its minterms
+};
+
+// Keeps the primes of on-set + don't cares, the chart (minterm -> primes and prime -> minterms)
+// and a minimum cover, and updates them when a single point changes:
+//  - a point joining on + dc: the new primes are exactly the primes that contain it, grown from
+//    the point itself; the old primes that stop being prime are the halves of those new primes
+//    on the other side of the point, so they are looked up instead of searched for,
+//  - a point leaving: the primes that contain it go; what replaces them can only be their
+//    subcubes with one '-' fixed away from the point, kept when they can't be expanded.
+// A minimum cover of the chart is the union of minimum covers of its connected parts, so only
+// the parts that hold a changed prime or minterm are solved again (PIChart + EPIs + the cover
+// solver, as in the full pipeline). The cover has the minimum number of cubes; between equal
+// ones it may pick differently from a full run.
+class IncrementalMinimizer {
+public:
+    explicit IncrementalMinimizer(int nbVars); // everything in the off-set
+    explicit IncrementalMinimizer(const BooleanFunction& function); // output 0 of the function
+
+    // move a point to the on-set / the off-set / the don't cares. false (with a message) when
+    // the term doesn't fit in nbVars; an edit that changes nothing is fine and costs nothing.
+    bool addMinterm(Term term);
+    bool removeMinterm(Term term);
+    bool setDontCare(Term term);
+
+    int nbVars() const { return n; }
+    std::vector<Term> minterms() const;  // sorted
+    std::vector<Term> dontCares() const; // sorted
+    std::vector<Cube> primes() const;    // every prime of on-set + don't cares, sorted
+    std::vector<Cube> cover() const;     // the current minimum cover, sorted
+    const IncrementalStats& lastEdit() const { return stats; }
+
+private:
+    int n;
+    uint64_t universe;
+    std::unordered_set<Term> onSet;
+    std::unordered_set<Term> dcSet;
+
+    // prime slots: freed slots are reused, primeIndex only has the live ones
+    std::vector<Cube> primeCubes;
+    std::vector<char> alive;
+    std::vector<char> selected;
+    std::vector<std::vector<Term>> primeMinterms;        // chart row: the minterms of a prime
+    std::unordered_map<Term, std::vector<int>> columnPrimes; // chart column: the primes of a minterm
+    std::unordered_map<Cube, int, CubeHash> primeIndex;
+    std::vector<int> freeSlots;
+
+    // cube -> lies in on + dc, valid until on + dc changes
+    std::unordered_map<Cube, bool, CubeHash> implicantMemo;
+    IncrementalStats stats;
+
+    bool fits(Term term) const;
+    bool inFunction(Term term) const { return onSet.count(term) || dcSet.count(term); }
+    bool isImplicant(const Cube& cube);
+    std::vector<Cube> primesContaining(Term point);
+
+    int addPrime(const Cube& cube);
+    void removePrime(int id);
+    void addColumn(Term minterm);
+    void removeColumn(Term minterm, std::vector<int>& touched);
+
+    // on + dc grows by / loses a point; the primes that changed go to touched, the minterms
+    // whose column lost a prime to seeds
+    void grow(Term point, std::vector<int>& touched, std::vector<Term>& seeds);
+    void shrink(Term point, std::vector<int>& touched, std::vector<Term>& seeds);
+
+    // solves the parts of the chart reachable from the seed minterms and the touched primes
+    void resolve(const std::vector<int>& touched, const std::vector<Term>& seeds);
+};
+
+#endif //QM_DD1_INCREMENTALMINIMIZER_H
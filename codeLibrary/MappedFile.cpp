@@ -0,0 +1,36 @@
+//
+// Read-only memory-mapped file, so the parser can work on the bytes in place.
+//
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        size = (size_t)info.st_size;
+        if (size == 0) {
+            opened = true; // nothing to map
+        } else {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+                opened = true;
+            } else {
+                size = 0;
+            }
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) munmap(const_cast<char*>(data), size);
+}
@@ -0,0 +1,30 @@
+//
+// Read-only memory-mapped file, so the parser can work on the bytes in place.
+//
+
+#ifndef QM_DD1_MAPPEDFILE_H
+#define QM_DD1_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile {
+public:
+    // maps the whole file; check isOpen() (an empty file is open with empty contents)
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    std::string_view contents() const { return std::string_view(data, size); }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+};
+
+#endif //QM_DD1_MAPPEDFILE_H
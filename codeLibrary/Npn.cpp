@@ -0,0 +1,289 @@
+//
+// NPN canonical forms: functions equal up to input permutation / negation (and output negation).
+//
+
+#include "Npn.h"
+
+#include <cstdio>
+
+namespace {
+
+// bit t set when bit i of t is 1, for t in 0..63
+const uint64_t kVarMask[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL,
+};
+
+// on-set terms * tied inputs above which the pair counts of the heuristic are skipped
+const uint64_t kPairBudget = 1ULL << 24;
+
+inline uint64_t tableMask(int n) {
+    return n == 6 ? ~0ULL : (1ULL << (1u << n)) - 1;
+}
+
+// T(t) -> T(t ^ 2^i)
+inline uint64_t negateVar(uint64_t table, int i) {
+    const unsigned shift = 1u << i;
+    const uint64_t low = ~kVarMask[i];
+    return ((table & low) << shift) | ((table >> shift) & low);
+}
+
+// T(t) -> T(t with bits i and j exchanged), i < j: a delta swap of the points where they differ
+inline uint64_t swapVars(uint64_t table, int i, int j) {
+    const unsigned shift = (1u << j) - (1u << i);
+    const uint64_t low = kVarMask[i] & ~kVarMask[j];
+    const uint64_t d = ((table >> shift) ^ table) & low;
+    return table ^ d ^ (d << shift);
+}
+
+// the exact search: tables are on0, dc0, on1, dc1, ... and every transform applies to all of them
+struct ExactSearch {
+    int n;
+    std::vector<uint64_t> tables;
+    std::vector<int> perm;
+    uint64_t negate = 0;
+    std::vector<uint64_t> best;
+    std::vector<int> bestPerm;
+    uint64_t bestNegate = 0;
+
+    void visit() {
+        if (tables < best) {
+            best = tables;
+            bestPerm = perm;
+            bestNegate = negate;
+        }
+    }
+    void flip(int i) {
+        for (uint64_t& t : tables) t = negateVar(t, i);
+        negate ^= 1ULL << i;
+    }
+    void exchange(int i, int j) {
+        if (i > j) std::swap(i, j);
+        for (uint64_t& t : tables) t = swapVars(t, i, j);
+        std::swap(perm[(size_t)i], perm[(size_t)j]);
+        const uint64_t bi = (negate >> i) & 1ULL, bj = (negate >> j) & 1ULL;
+        if (bi != bj) negate ^= (1ULL << i) | (1ULL << j);
+    }
+    // every negation of the current permutation, in Gray code order (one flip per step)
+    void visitNegations() {
+        visit();
+        for (uint64_t g = 1; g < (1ULL << n); ++g) {
+            flip(__builtin_ctzll(g));
+            visit();
+        }
+    }
+    // Heap's algorithm: one exchange per permutation
+    void run() {
+        best = tables;
+        bestPerm = perm;
+        std::vector<int> c((size_t)n, 0);
+        visitNegations();
+        int i = 1;
+        while (i < n) {
+            if (c[(size_t)i] < i) {
+                exchange((i % 2 == 0) ? 0 : c[(size_t)i], i);
+                visitNegations();
+                ++c[(size_t)i];
+                i = 1;
+            } else {
+                c[(size_t)i] = 0;
+                ++i;
+            }
+        }
+    }
+};
+
+std::vector<uint64_t> truthTables(const BooleanFunction& function) {
+    std::vector<uint64_t> tables;
+    for (size_t o = 0; o < function.outputCount(); ++o) {
+        uint64_t on = 0, dc = 0;
+        for (Term m : function.minterms[o]) on |= 1ULL << m;
+        for (Term d : function.dontCares[o]) dc |= 1ULL << d;
+        tables.push_back(on);
+        tables.push_back(dc & ~on);
+    }
+    return tables;
+}
+
+// exact canonical tables and the transform that gives them
+std::vector<uint64_t> exactCanonical(const BooleanFunction& function, NpnTransform& transform, bool allowOutputNegation) {
+    const int n = function.nbVars;
+    ExactSearch search{n, truthTables(function), NpnTransform::identity(n).perm, 0, {}, {}, 0};
+    search.run();
+    transform = NpnTransform::identity(n);
+    transform.perm = search.bestPerm;
+    transform.negate = search.bestNegate;
+
+    if (allowOutputNegation && function.outputCount() == 1) {
+        const std::vector<uint64_t> tables = truthTables(function);
+        ExactSearch negated{n, {~(tables[0] | tables[1]) & tableMask(n), tables[1]}, NpnTransform::identity(n).perm, 0, {}, {}, 0};
+        negated.run();
+        if (negated.best < search.best) {
+            transform.perm = negated.bestPerm;
+            transform.negate = negated.bestNegate;
+            transform.outputNegated = true;
+            return negated.best;
+        }
+    }
+    return search.best;
+}
+
+} // namespace
+
+NpnTransform NpnTransform::identity(int nbVars) {
+    NpnTransform transform;
+    transform.nbVars = nbVars;
+    for (int k = 0; k < nbVars; ++k) transform.perm.push_back(k);
+    return transform;
+}
+
+Term NpnTransform::toCanonical(Term t) const {
+    Term c = 0;
+    for (int k = 0; k < nbVars; ++k) c |= ((t >> perm[(size_t)k]) & 1ULL) << k;
+    return c ^ negate;
+}
+
+Term NpnTransform::fromCanonical(Term c) const {
+    c ^= negate;
+    Term t = 0;
+    for (int k = 0; k < nbVars; ++k) t |= ((c >> k) & 1ULL) << perm[(size_t)k];
+    return t;
+}
+
+Cube NpnTransform::toCanonical(const Cube& cube) const {
+    Cube c;
+    for (int k = 0; k < nbVars; ++k) {
+        c.mask |= ((cube.mask >> perm[(size_t)k]) & 1ULL) << k;
+        c.value |= ((cube.value >> perm[(size_t)k]) & 1ULL) << k;
+    }
+    c.value = (c.value ^ negate) & c.mask;
+    return c;
+}
+
+Cube NpnTransform::fromCanonical(const Cube& cube) const {
+    Cube c;
+    const Term value = (cube.value ^ negate) & cube.mask;
+    for (int k = 0; k < nbVars; ++k) {
+        c.mask |= ((cube.mask >> k) & 1ULL) << perm[(size_t)k];
+        c.value |= ((value >> k) & 1ULL) << perm[(size_t)k];
+    }
+    return c;
+}
+
+BooleanFunction Npn::canonicalize(const BooleanFunction& function, NpnTransform& transform, bool allowOutputNegation) {
+    const int n = function.nbVars;
+    BooleanFunction canonical;
+    canonical.nbVars = n;
+
+    if (n <= kExactVars) {
+        std::vector<uint64_t> tables = exactCanonical(function, transform, allowOutputNegation);
+        for (size_t o = 0; o < function.outputCount(); ++o) {
+            canonical.minterms.emplace_back();
+            canonical.dontCares.emplace_back();
+            for (Term t = 0; t < (1ULL << n); ++t) {
+                if ((tables[2 * o] >> t) & 1ULL) canonical.minterms.back().push_back(t);
+                if ((tables[2 * o + 1] >> t) & 1ULL) canonical.dontCares.back().push_back(t);
+            }
+        }
+        return canonical;
+    }
+
+    // signature heuristic: per input, how many on-set / don't care terms of each output have it at 1
+    transform = NpnTransform::identity(n);
+    const size_t outputs = function.outputCount();
+    std::vector<std::vector<uint64_t>> ones((size_t)n, std::vector<uint64_t>(2 * outputs, 0));
+    uint64_t onTotal = 0, dcTotal = 0, onOnes[64] = {0}, dcOnes[64] = {0};
+    for (size_t o = 0; o < outputs; ++o) {
+        for (int list = 0; list < 2; ++list) {
+            const std::vector<Term>& terms = list == 0 ? function.minterms[o] : function.dontCares[o];
+            (list == 0 ? onTotal : dcTotal) += terms.size();
+            for (Term t : terms) {
+                Term bits = t;
+                while (bits) {
+                    int i = __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    ++ones[(size_t)i][2 * o + (size_t)list];
+                    ++(list == 0 ? onOnes : dcOnes)[i];
+                }
+            }
+        }
+    }
+
+    // polarity: most on-set terms (then don't cares) have the input at 0
+    Term flip = 0;
+    for (int i = 0; i < n; ++i) {
+        bool negateInput = 2 * onOnes[i] > onTotal || (2 * onOnes[i] == onTotal && 2 * dcOnes[i] > dcTotal);
+        if (!negateInput) continue;
+        flip |= 1ULL << i;
+        for (size_t o = 0; o < outputs; ++o) {
+            ones[(size_t)i][2 * o] = function.minterms[o].size() - ones[(size_t)i][2 * o];
+            ones[(size_t)i][2 * o + 1] = function.dontCares[o].size() - ones[(size_t)i][2 * o + 1];
+        }
+    }
+    // inputs with equal counts are told apart by how often they are 1 together with each
+    // other input (a sorted list, so it doesn't depend on the input order either)
+    std::vector<char> tied((size_t)n, 0);
+    size_t tiedCount = 0;
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n && !tied[(size_t)i]; ++j)
+            if (j != i && ones[(size_t)i] == ones[(size_t)j]) tied[(size_t)i] = 1;
+    for (char t : tied) tiedCount += (size_t)t;
+    std::vector<std::vector<uint64_t>> pairs((size_t)n);
+    if (tiedCount > 0 && (onTotal + dcTotal) * tiedCount <= kPairBudget) {
+        for (int i = 0; i < n; ++i)
+            if (tied[(size_t)i]) pairs[(size_t)i].assign((size_t)n, 0);
+        for (size_t o = 0; o < outputs; ++o) {
+            for (Term t : function.minterms[o]) {
+                const Term normalized = t ^ flip;
+                Term bits = normalized;
+                while (bits) {
+                    int i = __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    if (!tied[(size_t)i]) continue;
+                    Term others = normalized & ~(1ULL << i);
+                    while (others) {
+                        ++pairs[(size_t)i][(size_t)__builtin_ctzll(others)];
+                        others &= others - 1;
+                    }
+                }
+            }
+        }
+        for (std::vector<uint64_t>& p : pairs) sort(p.begin(), p.end());
+    }
+    std::stable_sort(transform.perm.begin(), transform.perm.end(), [&](int a, int b) {
+        if (ones[(size_t)a] != ones[(size_t)b]) return ones[(size_t)a] < ones[(size_t)b];
+        return pairs[(size_t)a] < pairs[(size_t)b];
+    });
+    for (int k = 0; k < n; ++k)
+        if ((flip >> transform.perm[(size_t)k]) & 1ULL) transform.negate |= 1ULL << k;
+
+    for (size_t o = 0; o < outputs; ++o) {
+        canonical.minterms.emplace_back();
+        canonical.dontCares.emplace_back();
+        for (Term t : function.minterms[o]) canonical.minterms.back().push_back(transform.toCanonical(t));
+        for (Term t : function.dontCares[o]) canonical.dontCares.back().push_back(transform.toCanonical(t));
+        sort(canonical.minterms.back().begin(), canonical.minterms.back().end());
+        sort(canonical.dontCares.back().begin(), canonical.dontCares.back().end());
+    }
+    return canonical;
+}
+
+void Npn::mapResult(MinimizationResult& result, const NpnTransform& transform, bool toCanonical) {
+    for (Implicant& imp : result.primes) {
+        imp.cube = toCanonical ? transform.toCanonical(imp.cube) : transform.fromCanonical(imp.cube);
+        for (Term& t : imp.covered) t = toCanonical ? transform.toCanonical(t) : transform.fromCanonical(t);
+        sort(imp.covered.begin(), imp.covered.end());
+    }
+    for (Term& t : result.remaining) t = toCanonical ? transform.toCanonical(t) : transform.fromCanonical(t);
+}
+
+std::string Npn::classOf(const BooleanFunction& function) {
+    if (function.outputCount() != 1 || function.nbVars > kExactVars) return "";
+    NpnTransform transform;
+    std::vector<uint64_t> tables = exactCanonical(function, transform, true);
+    const int digits = function.nbVars <= 2 ? 1 : (1 << function.nbVars) / 4;
+    char text[64];
+    snprintf(text, sizeof(text), "n%d on=%0*llx dc=%0*llx", function.nbVars,
+             digits, (unsigned long long)tables[0], digits, (unsigned long long)tables[1]);
+    return text;
+}
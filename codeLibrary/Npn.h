@@ -0,0 +1,53 @@
+//
+// NPN canonical forms: functions equal up to input permutation / negation (and output negation).
+//
+
+#ifndef QM_DD1_NPN_H
+#define QM_DD1_NPN_H
+
+#include <string>
+#include <vector>
+
+#include "FileManip.h"
+
+// canonical = transform(original): canonical bit k is original bit perm[k], complemented when
+// bit k of negate is set. outputNegated swaps the on-set and the off-set (don't cares stay).
+struct NpnTransform {
+    int nbVars = 0;
+    std::vector<int> perm;
+    Term negate = 0;
+    bool outputNegated = false;
+
+    static NpnTransform identity(int nbVars);
+
+    Term toCanonical(Term t) const;
+    Term fromCanonical(Term c) const;
+    Cube toCanonical(const Cube& cube) const;
+    Cube fromCanonical(const Cube& cube) const;
+};
+
+class Npn {
+public:
+    // up to this many variables the truth tables fit in one word and every transform is tried
+    static const int kExactVars = 6;
+
+    // Canonical representative of the function's class and the transform to it. Exact (the
+    // smallest truth tables over all n! * 2^n input transforms) for n <= kExactVars; above that
+    // a signature heuristic: each input is complemented so most on-set terms have it at 0, then
+    // inputs are sorted by their per-output cofactor counts, ties by their pairwise counts (and
+    // then the input order, so some equivalent functions get different representatives; it is
+    // never wrong, only a miss).
+    // Output negation is only tried with allowOutputNegation, on single-output functions with
+    // n <= kExactVars (the off-set has to be enumerated).
+    static BooleanFunction canonicalize(const BooleanFunction& function, NpnTransform& transform, bool allowOutputNegation);
+
+    // a minimization result moved to / back from the canonical variables. Only valid for NP
+    // transforms: a cover of the complement says nothing about a cover of the function.
+    static void mapResult(MinimizationResult& result, const NpnTransform& transform, bool toCanonical);
+
+    // "n4 on=00f0 dc=0000" for single-output functions with n <= kExactVars (equal strings =
+    // same NPN class), empty otherwise
+    static std::string classOf(const BooleanFunction& function);
+};
+
+#endif //QM_DD1_NPN_H
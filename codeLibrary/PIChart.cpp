@@ -0,0 +1,173 @@
+//
+// Bit-packed prime implicant chart.
+//
+
+#include "PIChart.h"
+
+#include <array>
+
+#include "Profile.h"
+#include "WidthClass.h"
+
+namespace {
+
+// Sets the bits of every row and counts the rows of each column. Up to 8 variables every point
+// has a slot in a stack table per output, so a cube's points are looked up directly; past that a
+// small cube looks its points up by binary search and a big one tests every column.
+template <int Width>
+void markRows(PIChart& chart, const std::vector<Implicant>& primes, uint64_t universe, std::vector<int>& perColumn) {
+    if constexpr (Width <= 8) {
+        std::array<int, 256> columnAt;
+        for (size_t o = 0; o < chart.outputCount; ++o) {
+            columnAt.fill(-1);
+            for (size_t c = chart.outputStart[o]; c < chart.outputStart[o + 1]; ++c)
+                columnAt[(size_t)chart.columnMinterms[c]] = (int)c;
+            for (size_t r = 0; r < chart.rowCount; ++r) {
+                const Cube& cube = primes[r].cube;
+                // a fixed 1 above the highest minterm bit: no minterm in it
+                if (!((primes[r].outputs >> o) & 1ULL) || (cube.value & ~universe)) continue;
+                uint64_t* row = chart.bits.data() + r * chart.words;
+                const uint64_t freeBits = ~cube.mask & universe;
+                uint64_t sub = 0;
+                do {
+                    const int column = columnAt[(size_t)(cube.value | sub)];
+                    if (column >= 0) {
+                        row[column / 64] |= 1ULL << (column % 64);
+                        ++perColumn[(size_t)column];
+                    }
+                    sub = (sub - freeBits) & freeBits; // next subset of the free bits
+                } while (sub != 0);
+            }
+        }
+    } else {
+        for (size_t r = 0; r < chart.rowCount; ++r) {
+            const Cube& cube = primes[r].cube;
+            uint64_t* row = chart.bits.data() + r * chart.words;
+            uint64_t freeBits = ~cube.mask & universe;
+            int freeCount = popcount64(freeBits);
+            auto mark = [&](size_t c) {
+                row[c / 64] |= 1ULL << (c % 64);
+                ++perColumn[c];
+            };
+            // only the columns of the outputs this prime belongs to
+            for (size_t o = 0; o < chart.outputCount; ++o) {
+                if (!((primes[r].outputs >> o) & 1ULL)) continue;
+                const size_t begin = chart.outputStart[o];
+                const size_t end = chart.outputStart[o + 1];
+                if (freeCount < 32 && (16ULL << freeCount) <= end - begin) {
+                    // small cube: walk its points and look each one up
+                    uint64_t sub = 0;
+                    do {
+                        int column = chart.columnOf(cube.value | sub, (int)o);
+                        if (column >= 0) mark((size_t)column);
+                        sub = (sub - freeBits) & freeBits; // next subset of the free bits
+                    } while (sub != 0);
+                } else {
+                    // big cube: test every column
+                    for (size_t c = begin; c < end; ++c)
+                        if (cube.contains(chart.columnMinterms[c])) mark(c);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+PIChart PIChart::build(const std::vector<Implicant>& primes, const std::vector<Term>& minterms) {
+    return build(primes, std::vector<std::vector<Term>>{minterms});
+}
+
+PIChart PIChart::build(const std::vector<Implicant>& primes, const std::vector<std::vector<Term>>& mintermsPerOutput) {
+    QM_PROFILE_TIMER("PIChart::build");
+    PIChart chart;
+    chart.outputCount = mintermsPerOutput.size();
+    chart.outputStart.push_back(0);
+    Term largest = 0;
+    for (size_t o = 0; o < chart.outputCount; ++o) {
+        std::vector<Term> terms = mintermsPerOutput[o];
+        sort(terms.begin(), terms.end());
+        terms.erase(unique(terms.begin(), terms.end()), terms.end());
+        if (!terms.empty()) largest = std::max(largest, terms.back());
+        chart.columnMinterms.insert(chart.columnMinterms.end(), terms.begin(), terms.end());
+        chart.columnOutputs.insert(chart.columnOutputs.end(), terms.size(), (int)o);
+        chart.outputStart.push_back(chart.columnMinterms.size());
+    }
+    chart.rowCount = primes.size();
+    chart.columnCount = chart.columnMinterms.size();
+    chart.words = (chart.columnCount + 63) / 64;
+    chart.bits.assign(chart.rowCount * chart.words, 0);
+
+    // variables above the highest minterm bit can't matter: any point using them is bigger
+    // than every minterm
+    int width = 0;
+    while (width < 64 && (largest >> width) != 0) ++width;
+    const uint64_t universe = Cube::fullMask(width);
+
+    std::vector<int> perColumn(chart.columnCount, 0);
+    // only the smallest class gets its own lookup, past it the point -> column table would be 2^n
+    if (WidthClass::of(width) == 8) markRows<8>(chart, primes, universe, perColumn);
+    else markRows<64>(chart, primes, universe, perColumn);
+
+    // CSR columns, rows ascending
+    chart.columnStart.assign(chart.columnCount + 1, 0);
+    for (size_t c = 0; c < chart.columnCount; ++c)
+        chart.columnStart[c + 1] = chart.columnStart[c] + perColumn[c];
+    chart.columnRows.resize((size_t)chart.columnStart[chart.columnCount]);
+    std::vector<int> fill(chart.columnStart.begin(), chart.columnStart.end() - 1);
+    for (size_t r = 0; r < chart.rowCount; ++r) {
+        const uint64_t* row = chart.row(r);
+        for (size_t w = 0; w < chart.words; ++w) {
+            uint64_t word = row[w];
+            while (word) {
+                size_t c = w * 64 + (size_t)__builtin_ctzll(word);
+                word &= word - 1;
+                chart.columnRows[(size_t)fill[c]++] = (int)r;
+            }
+        }
+    }
+    return chart;
+}
+
+int PIChart::columnOf(Term minterm, int output) const {
+    if (output < 0 || (size_t)output >= outputCount) return -1;
+    auto first = columnMinterms.begin() + (std::ptrdiff_t)outputStart[(size_t)output];
+    auto last = columnMinterms.begin() + (std::ptrdiff_t)outputStart[(size_t)output + 1];
+    auto it = lower_bound(first, last, minterm);
+    if (it == last || *it != minterm) return -1;
+    return (int)(it - columnMinterms.begin());
+}
+
+std::vector<int> PIChart::uncoveredColumns(const std::vector<int>& rows) const {
+    std::vector<uint64_t> covered = coverage(rows);
+    std::vector<int> columns;
+    for (size_t c = 0; c < columnCount; ++c)
+        if (!((covered[c / 64] >> (c % 64)) & 1ULL))
+            columns.push_back((int)c);
+    return columns;
+}
+
+std::vector<uint64_t> PIChart::coverage(const std::vector<int>& rows) const {
+    std::vector<uint64_t> result(words, 0);
+    for (int r : rows) {
+        const uint64_t* bitsR = row((size_t)r);
+        for (size_t w = 0; w < words; ++w) result[w] |= bitsR[w];
+    }
+    return result;
+}
+
+std::vector<std::vector<uint64_t>> PIChart::subChart(const std::vector<int>& rows, const std::vector<int>& columns) const {
+    const size_t subWords = (columns.size() + 63) / 64;
+    std::vector<std::vector<uint64_t>> result(rows.size(), std::vector<uint64_t>(subWords, 0));
+    std::vector<int> subRow(rowCount, -1); // chart row -> index in rows
+    for (size_t i = 0; i < rows.size(); ++i) subRow[(size_t)rows[i]] = (int)i;
+    for (size_t k = 0; k < columns.size(); ++k) {
+        const uint64_t bit = 1ULL << (k % 64);
+        const size_t c = (size_t)columns[k];
+        for (int j = columnStart[c]; j < columnStart[c + 1]; ++j) {
+            int i = subRow[(size_t)columnRows[(size_t)j]];
+            if (i >= 0) result[(size_t)i][k / 64] |= bit;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+//
+// Bit-packed prime implicant chart.
+//
+
+#ifndef QM_DD1_PICHART_H
+#define QM_DD1_PICHART_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Implicant.h"
+
+// One row per prime, one column per minterm (don't cares are not columns). Minterms are
+// sorted and renumbered 0..k-1, so a row is a dense bit set over the columns and a column is
+// a CSR slice of the rows that cover it. Essentials, uncovered minterms and the cover solver
+// then only need popcounts and ANDs on the rows.
+// With several outputs a column is an (output, minterm) pair, the outputs one after the other,
+// and a prime only covers the columns of the outputs in its mask. Picking a row once covers
+// its minterms in all of them, which is how product terms get shared.
+class PIChart {
+public:
+    size_t rowCount = 0;
+    size_t columnCount = 0;
+    size_t words = 0;                 // uint64_t words per row
+    size_t outputCount = 1;
+    std::vector<Term> columnMinterms; // column -> minterm, ascending within each output
+    std::vector<int> columnOutputs;   // column -> output
+    std::vector<size_t> outputStart;  // columns of output o are outputStart[o] .. outputStart[o+1]
+    std::vector<uint64_t> bits;       // rowCount * words, row r starts at r * words
+    std::vector<int> columnStart;     // CSR: rows of column c are columnRows[columnStart[c] .. columnStart[c+1])
+    std::vector<int> columnRows;
+
+    static PIChart build(const std::vector<Implicant>& primes, const std::vector<Term>& minterms);
+    static PIChart build(const std::vector<Implicant>& primes, const std::vector<std::vector<Term>>& mintermsPerOutput);
+
+    const uint64_t* row(size_t r) const { return bits.data() + r * words; }
+    bool covers(size_t r, size_t c) const { return (row(r)[c / 64] >> (c % 64)) & 1ULL; }
+    int rowsCovering(size_t c) const { return columnStart[c + 1] - columnStart[c]; }
+
+    // column of a minterm of an output, -1 if it isn't one
+    int columnOf(Term minterm, int output = 0) const;
+
+    // OR of the given rows: the columns they cover together
+    std::vector<uint64_t> coverage(const std::vector<int>& rows) const;
+    // columns none of the given rows cover, ascending
+    std::vector<int> uncoveredColumns(const std::vector<int>& rows) const;
+
+    // the given rows restricted to the given columns, repacked as bit rows over those columns only
+    std::vector<std::vector<uint64_t>> subChart(const std::vector<int>& rows, const std::vector<int>& columns) const;
+};
+
+#endif //QM_DD1_PICHART_H
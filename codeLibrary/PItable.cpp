@@ -4,14 +4,468 @@
 
 #include "PItable.h"
 
+#include "Profile.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// below these a node / an absorb size class runs on the calling thread
+const size_t kParallelProducts = 1 << 14;
+const size_t kParallelSubsetTests = 1 << 16;
+// how much a product buffer grows between two checks of the memory ceiling
+const size_t kBudgetStep = 1 << 20;
+// the dominance steps of reduceChart compare every pair of rows / columns: past this many word
+// compares per round a step is skipped (the solver then gets a bigger chart, still correct)
+const double kMaxDominanceWords = 1 << 30;
+
+// Product terms of Petrick's method as fixed-width bit rows: term k is the words
+// [k * width, (k + 1) * width), bit r set when it has PI (chart row) r. One flat buffer for the
+// whole expression, so multiplying or absorbing never allocates per term.
+struct TermTable {
+    size_t width = 1;
+    std::vector<uint64_t> bits;
+    std::vector<int> sizes; // number of PIs of each term
+
+    explicit TermTable(size_t termWidth) : width(termWidth) {}
+
+    size_t size() const { return sizes.size(); }
+    const uint64_t* term(size_t k) const { return bits.data() + k * width; }
+    void push(const uint64_t* t, int size) {
+        bits.insert(bits.end(), t, t + width);
+        sizes.push_back(size);
+    }
+};
+
+int countBits(const uint64_t* t, size_t width) {
+    int count = 0;
+    for (size_t w = 0; w < width; ++w) count += popcount64(t[w]);
+    return count;
+}
+
+// a is a subset of b
+bool isSubset(const uint64_t* a, const uint64_t* b, size_t width) {
+    for (size_t w = 0; w < width; ++w)
+        if (a[w] & ~b[w]) return false;
+    return true;
+}
+
+bool intersects(const uint64_t* a, const uint64_t* b, size_t width) {
+    for (size_t w = 0; w < width; ++w)
+        if (a[w] & b[w]) return true;
+    return false;
+}
+
+// Absorption (X + XY = X) with duplicates removed by hash first. The survivors come out by size
+// (stable, so equal-size terms keep their order) and a term is only tested against the kept
+// terms of smaller size, with a word-parallel subset test. Kept terms are bucketed by their
+// lowest PI, so a term only looks at the buckets of its own PIs. Distinct terms of one size
+// can't absorb each other, so with a pool the terms of a size are tested in parallel.
+TermTable absorb(const TermTable& terms, ThreadPool* pool = nullptr) {
+    const size_t width = terms.width;
+    auto hashOf = [&](size_t k) {
+        uint64_t h = 0x9e3779b97f4a7c15ULL;
+        for (size_t w = 0; w < width; ++w) h = (h ^ terms.term(k)[w]) * 0x100000001b3ULL;
+        return (size_t)h;
+    };
+    auto sameTerm = [&](size_t a, size_t b) {
+        return std::equal(terms.term(a), terms.term(a) + width, terms.term(b));
+    };
+    std::unordered_set<size_t, decltype(hashOf), decltype(sameTerm)> distinct(terms.size() * 2, hashOf, sameTerm);
+    std::vector<size_t> order;
+    for (size_t k = 0; k < terms.size(); ++k)
+        if (distinct.insert(k).second) order.push_back(k);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return terms.sizes[a] < terms.sizes[b]; });
+
+    TermTable kept(width);
+    std::vector<std::vector<size_t>> byLowest(width * 64);
+    std::vector<char> absorbed;
+    for (size_t begin = 0, end = 0; begin < order.size(); begin = end) {
+        while (end < order.size() && terms.sizes[order[end]] == terms.sizes[order[begin]]) ++end;
+        const size_t smaller = kept.size(); // every kept term is smaller than this size
+        // the empty term (only in an expression that is already true) absorbs everything
+        absorbed.assign(end - begin, smaller > 0 && kept.sizes[0] == 0);
+        auto test = [&](size_t from, size_t to) {
+            for (size_t i = from; i < to; ++i) {
+                const uint64_t* t = terms.term(order[begin + i]);
+                for (size_t w = 0; w < width && !absorbed[i]; ++w) {
+                    for (uint64_t bits = t[w]; bits && !absorbed[i]; bits &= bits - 1) {
+                        for (size_t j : byLowest[w * 64 + (size_t)__builtin_ctzll(bits)]) {
+                            if (isSubset(kept.term(j), t, width)) {
+                                absorbed[i] = 1;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        };
+        const size_t chunks = (pool && pool->size() > 1 && (end - begin) * smaller >= kParallelSubsetTests)
+            ? std::min(end - begin, (size_t)pool->size() * 4) : 1;
+        if (chunks > 1) {
+            pool->run(chunks, [&](size_t c) { test((end - begin) * c / chunks, (end - begin) * (c + 1) / chunks); });
+        } else {
+            test(0, end - begin);
+        }
+        for (size_t i = 0; i < end - begin; ++i) {
+            if (absorbed[i]) continue;
+            const uint64_t* t = terms.term(order[begin + i]);
+            for (size_t w = 0; w < width; ++w) {
+                if (!t[w]) continue;
+                byLowest[w * 64 + (size_t)__builtin_ctzll(t[w])].push_back(kept.size());
+                break;
+            }
+            kept.push(t, terms.sizes[order[begin + i]]);
+        }
+    }
+    return kept;
+}
+
+// the product of sums of a chart, one sum (bit row over the chart rows) per column. false when
+// a column has no row
+bool buildSums(const std::vector<std::vector<uint64_t>>& rows, size_t columnCount, TermTable& sums) {
+    const size_t width = sums.width;
+    std::vector<uint64_t> sum(width);
+    for (size_t c = 0; c < columnCount; ++c) {
+        std::fill(sum.begin(), sum.end(), 0);
+        for (size_t r = 0; r < rows.size(); ++r) {
+            // checking if this non-essential PI covers the minterm (its bit in the chart row)
+            if ((rows[r][c / 64] >> (c % 64)) & 1ULL) sum[r / 64] |= 1ULL << (r % 64);
+        }
+        int size = countBits(sum.data(), width);
+        if (size == 0) {
+            std::cerr << "Error: a minterm is uncovered by non-essential PIs.\n";
+            return false;
+        }
+        sums.push(sum.data(), size);
+    }
+    return true;
+}
+
+// greedy cover: no minimum cover has more PIs than this
+int greedyCoverSize(const std::vector<std::vector<uint64_t>>& rows, size_t columnCount) {
+    int bound = 0;
+    const size_t columnWords = (columnCount + 63) / 64;
+    std::vector<uint64_t> uncovered(columnWords, ~0ULL);
+    if (columnCount % 64) uncovered[columnWords - 1] = (1ULL << (columnCount % 64)) - 1ULL;
+    while (true) {
+        size_t best = rows.size();
+        int bestGain = 0;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            int gain = 0;
+            for (size_t w = 0; w < columnWords; ++w) gain += popcount64(rows[r][w] & uncovered[w]);
+            if (gain > bestGain) { best = r; bestGain = gain; }
+        }
+        if (best == rows.size()) break;
+        for (size_t w = 0; w < columnWords; ++w) uncovered[w] &= ~rows[best][w];
+        ++bound;
+    }
+    return bound;
+}
+
+// the terms of the minimum size, as sorted ProductTerms of chart PIs
+std::vector<ProductTerm> smallestTerms(const TermTable& expression, const std::vector<int>& rowPIs) {
+    std::vector<ProductTerm> minimalSolutions;
+    if (expression.size() == 0) return minimalSolutions;
+    const int minSize = *std::min_element(expression.sizes.begin(), expression.sizes.end());
+    for (size_t k = 0; k < expression.size(); ++k) {
+        if (expression.sizes[k] != minSize) continue;
+        ProductTerm term;
+        for (size_t w = 0; w < expression.width; ++w)
+            for (uint64_t bits = expression.term(k)[w]; bits; bits &= bits - 1)
+                term.insert(rowPIs[w * 64 + (size_t)__builtin_ctzll(bits)]);
+        minimalSolutions.push_back(term);
+    }
+    std::sort(minimalSolutions.begin(), minimalSolutions.end());
+    return minimalSolutions;
+}
+
+// bytes held by the tree's expressions, shared by the tasks of a level. Once past the limit
+// every task stops at its next check and the tree gives up.
+struct MemoryBudget {
+    size_t limit = 0; // 0 = none
+    std::atomic<size_t> used{0};
+    std::atomic<size_t> peak{0};
+    std::atomic<bool> exceeded{false};
+
+    bool add(size_t bytes) {
+        const size_t now = used.fetch_add(bytes) + bytes;
+        size_t seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        if (limit != 0 && now > limit) exceeded = true;
+        return !exceeded;
+    }
+    void release(size_t bytes) { used.fetch_sub(bytes); }
+};
+
+size_t tableBytes(const TermTable& table) {
+    return table.bits.size() * sizeof(uint64_t) + table.sizes.size() * sizeof(int);
+}
+
+// A part of the tree only multiplies some of the sums. outside holds pairwise disjoint sums
+// from the rest: a cover containing t still needs a PI of its own for each of them t misses,
+// so t can't grow into a cover of at most bound PIs when size + misses > bound.
+bool withinBound(const uint64_t* t, int size, int bound, const TermTable* outside) {
+    if (size > bound) return false;
+    if (!outside) return true;
+    for (size_t k = 0; k < outside->size() && size <= bound; ++k)
+        if (!intersects(t, outside->term(k), outside->width)) ++size;
+    return size <= bound;
+}
+
+// the pairwise disjoint sums for a part of the tree: the smallest first, from the sums whose
+// inPart flag is 0
+TermTable disjointSums(const TermTable& sums, const std::vector<char>& inPart) {
+    TermTable picked(sums.width);
+    std::vector<uint64_t> used(sums.width, 0);
+    for (size_t k = 0; k < sums.size(); ++k) {
+        if (inPart[k] || intersects(sums.term(k), used.data(), sums.width)) continue;
+        picked.push(sums.term(k), sums.sizes[k]);
+        for (size_t w = 0; w < sums.width; ++w) used[w] |= sums.term(k)[w];
+    }
+    return picked;
+}
+
+// Petrick's product of the sums in `which`, left to right from the empty product (see
+// solveByPetrick). After each sum the terms that fail withinBound against the disjoint sums
+// still to come are dropped: they can't grow into a cover of at most bound PIs. A term that
+// fails it only has supersets that fail it too, so nothing it would absorb survives.
+void multiplySums(const TermTable& sums, const std::vector<size_t>& which, int bound, TermTable& expression) {
+    const size_t width = sums.width;
+    expression = TermTable(width);
+    std::vector<uint64_t> empty(width, 0);
+    expression.push(empty.data(), 0);
+    std::vector<std::vector<size_t>> buckets(width * 64); // x -> terms whose PIs in S are {x}
+    std::vector<uint64_t> product(width);
+    std::vector<char> done(sums.size(), 1); // multiplied in, or not part of `which`
+    for (size_t s : which) done[s] = 0;
+    for (size_t s : which) {
+        const uint64_t* S = sums.term(s);
+        done[s] = 1;
+        const TermTable outside = disjointSums(sums, done);
+        TermTable next(width);
+        std::vector<size_t> missing; // terms of the expression without a PI of S
+        for (size_t k = 0; k < expression.size(); ++k) {
+            const uint64_t* t = expression.term(k);
+            if (!intersects(t, S, width)) {
+                if (expression.sizes[k] < bound) missing.push_back(k);
+                continue;
+            }
+            if (!withinBound(t, expression.sizes[k], bound, &outside)) continue;
+            next.push(t, expression.sizes[k]);
+            int inS = 0;
+            size_t x = 0;
+            for (size_t w = 0; w < width && inS < 2; ++w) {
+                uint64_t both = t[w] & S[w];
+                inS += popcount64(both);
+                if (both) x = w * 64 + (size_t)__builtin_ctzll(both);
+            }
+            if (inS == 1) buckets[x].push_back(next.size() - 1);
+        }
+        QM_PROFILE_ONLY(const size_t unchanged = next.size(); size_t products = 0;)
+        for (size_t w = 0; w < width; ++w) {
+            for (uint64_t bits = S[w]; bits; bits &= bits - 1) {
+                const size_t x = w * 64 + (size_t)__builtin_ctzll(bits);
+                std::vector<size_t>& bucket = buckets[x];
+                // kept terms were pushed in the expression's size order, so the bucket is sorted
+                for (size_t k : missing) {
+                    const uint64_t* t = expression.term(k);
+                    std::copy(t, t + width, product.begin());
+                    product[x / 64] |= 1ULL << (x % 64);
+                    QM_PROFILE_ONLY(++products;)
+                    if (!withinBound(product.data(), expression.sizes[k] + 1, bound, &outside)) continue;
+                    bool absorbed = false;
+                    for (size_t j = 0; j < bucket.size() && !absorbed; ++j) {
+                        if (next.sizes[bucket[j]] > expression.sizes[k]) break;
+                        absorbed = isSubset(next.term(bucket[j]), product.data(), width);
+                    }
+                    if (!absorbed) next.push(product.data(), expression.sizes[k] + 1);
+                }
+                bucket.clear();
+            }
+        }
+        QM_PROFILE_APPEND("petrick.termsBeforeAbsorption", unchanged + products);
+        QM_PROFILE_APPEND("petrick.termsAfterAbsorption", next.size());
+        // keep the expression sorted by size (the new terms are one PI longer than their source)
+        std::vector<size_t> order(next.size());
+        for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return next.sizes[a] < next.sizes[b]; });
+        expression = TermTable(width);
+        for (size_t k : order) expression.push(next.term(k), next.sizes[k]);
+    }
+}
+
+// Petrick tree leaves in multiplication order: the smallest sum first, then each time the
+// unused sum sharing the most PIs with the last one (the smallest on a tie). Neighbours are
+// multiplied together first, and a product of sums with a common PI x keeps x on its own,
+// which absorbs every other product that has x.
+std::vector<size_t> clusterSums(const TermTable& sums) {
+    std::vector<size_t> order;
+    std::vector<char> used(sums.size(), 0);
+    size_t last = 0; // absorb() sorted the sums by size
+    for (size_t step = 0; step < sums.size(); ++step) {
+        if (step > 0) {
+            int bestShared = -1;
+            for (size_t k = 0; k < sums.size(); ++k) {
+                if (used[k]) continue;
+                int shared = 0;
+                for (size_t w = 0; w < sums.width; ++w) shared += popcount64(sums.term(k)[w] & sums.term(last)[w]);
+                if (shared > bestShared) { bestShared = shared; last = k; }
+            }
+        }
+        used[last] = 1;
+        order.push_back(last);
+    }
+    return order;
+}
+
+// terms of `of` that contain some term of `in`, by the same lowest-PI buckets as absorb()
+std::vector<char> containsATerm(const TermTable& of, const TermTable& in) {
+    const size_t width = of.width;
+    std::vector<std::vector<size_t>> byLowest(width * 64);
+    bool hasEmpty = false;
+    for (size_t j = 0; j < in.size(); ++j) {
+        const uint64_t* t = in.term(j);
+        size_t w = 0;
+        while (w < width && !t[w]) ++w;
+        if (w == width) hasEmpty = true;
+        else byLowest[w * 64 + (size_t)__builtin_ctzll(t[w])].push_back(j);
+    }
+    std::vector<char> result(of.size(), hasEmpty);
+    for (size_t i = 0; i < of.size() && !hasEmpty; ++i) {
+        const uint64_t* t = of.term(i);
+        for (size_t w = 0; w < width && !result[i]; ++w)
+            for (uint64_t bits = t[w]; bits && !result[i]; bits &= bits - 1)
+                for (size_t j : byLowest[w * 64 + (size_t)__builtin_ctzll(bits)])
+                    if (isSubset(in.term(j), t, width)) {
+                        result[i] = 1;
+                        break;
+                    }
+    }
+    return result;
+}
+
+// One node of the tree: a x b absorbed, without the products failing withinBound. A term t
+// of a that contains a term u of b is t|u = t itself, and every other product of t contains t,
+// so it goes through alone (the same the other way round); only the remaining pairs are
+// multiplied. Big nodes split those rows of a between pool tasks, each with its own buffer.
+bool multiplyNode(const TermTable& a, const TermTable& b, int bound, const TermTable* outside, ThreadPool* pool,
+                  MemoryBudget& budget, TermTable& out) {
+    const size_t width = a.width;
+    const std::vector<char> aAlone = containsATerm(a, b);
+    const std::vector<char> bAlone = containsATerm(b, a);
+    std::vector<size_t> aRest, bRest;
+    TermTable alone(width);
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!aAlone[i]) aRest.push_back(i);
+        else if (withinBound(a.term(i), a.sizes[i], bound, outside)) alone.push(a.term(i), a.sizes[i]);
+    }
+    for (size_t j = 0; j < b.size(); ++j) {
+        if (!bAlone[j]) bRest.push_back(j);
+        else if (withinBound(b.term(j), b.sizes[j], bound, outside)) alone.push(b.term(j), b.sizes[j]);
+    }
+
+    const size_t chunks = (pool && pool->size() > 1 && aRest.size() * bRest.size() >= kParallelProducts)
+        ? std::min(aRest.size(), (size_t)pool->size() * 4) : 1;
+    std::vector<TermTable> parts(chunks, TermTable(width));
+    parts[0] = std::move(alone);
+    auto multiply = [&](size_t c) {
+        TermTable& part = parts[c];
+        std::vector<uint64_t> product(width);
+        size_t accounted = 0;
+        for (size_t ii = aRest.size() * c / chunks; ii < aRest.size() * (c + 1) / chunks; ++ii) {
+            const uint64_t* t = a.term(aRest[ii]);
+            for (size_t j : bRest) {
+                for (size_t w = 0; w < width; ++w) product[w] = t[w] | b.term(j)[w];
+                const int size = countBits(product.data(), width);
+                if (withinBound(product.data(), size, bound, outside)) part.push(product.data(), size);
+            }
+            if (tableBytes(part) - accounted >= kBudgetStep) {
+                const size_t grown = tableBytes(part) - accounted;
+                accounted += grown;
+                if (!budget.add(grown)) break;
+            }
+            if (budget.exceeded) break;
+        }
+        budget.add(tableBytes(part) - accounted);
+    };
+    if (chunks > 1) pool->run(chunks, multiply);
+    else multiply(0);
+
+    size_t productBytes = 0;
+    for (const TermTable& part : parts) productBytes += tableBytes(part);
+    if (budget.exceeded) {
+        budget.release(productBytes);
+        return false;
+    }
+    TermTable products(width);
+    if (chunks == 1) {
+        products = std::move(parts[0]);
+    } else {
+        for (TermTable& part : parts) {
+            products.bits.insert(products.bits.end(), part.bits.begin(), part.bits.end());
+            products.sizes.insert(products.sizes.end(), part.sizes.begin(), part.sizes.end());
+            part = TermTable(width);
+        }
+    }
+    QM_PROFILE_APPEND("petrick.termsBeforeAbsorption", products.size());
+    out = absorb(products, pool);
+    QM_PROFILE_APPEND("petrick.termsAfterAbsorption", out.size());
+    budget.release(productBytes);
+    return budget.add(tableBytes(out));
+}
+
+// ProductTerms <-> bit rows over the PI indices they use
+TermTable toTable(const BooleanExpression& exp, std::vector<int>& indices) {
+    for (const auto& term : exp) indices.insert(indices.end(), term.begin(), term.end());
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    TermTable table(std::max<size_t>((indices.size() + 63) / 64, 1));
+    std::vector<uint64_t> row(table.width);
+    for (const auto& term : exp) {
+        std::fill(row.begin(), row.end(), 0);
+        for (int pi : term) {
+            size_t bit = (size_t)(std::lower_bound(indices.begin(), indices.end(), pi) - indices.begin());
+            row[bit / 64] |= 1ULL << (bit % 64);
+        }
+        table.push(row.data(), (int)term.size());
+    }
+    return table;
+}
+
+BooleanExpression fromTable(const TermTable& table, const std::vector<int>& indices) {
+    BooleanExpression exp;
+    for (size_t k = 0; k < table.size(); ++k) {
+        ProductTerm term;
+        for (size_t w = 0; w < table.width; ++w)
+            for (uint64_t bits = table.term(k)[w]; bits; bits &= bits - 1)
+                term.insert(indices[w * 64 + (size_t)__builtin_ctzll(bits)]);
+        exp.push_back(term);
+    }
+    return exp;
+}
+
+} // namespace
+
 
 
 
 std::vector<ProductTerm> PItable::solvePIMatrixAndMinimize(
     const std::vector<Implicant>& primes,
+    const PIChart& chart,
     const std::vector<int>& essential,
-    const std::vector<int>& remainingMinterms
+    const std::vector<int>& remainingColumns,
+    CoverMode mode,
+    bool reduce,
+    size_t maxSolutions,
+    ThreadPool* pool,
+    size_t memoryLimit,
+    size_t searchNodes,
+    bool* gaveUp,
+    size_t* omitted
 ) {
+    QM_PROFILE_TIMER("solvePIMatrixAndMinimize");
+    if (gaveUp != nullptr) *gaveUp = false;
+    if (omitted != nullptr) *omitted = 0;
     // removing any minterms that are already included in the EPIs
     std::unordered_set<int> essentialSet(essential.begin(), essential.end());
     std::vector<int> nonEssentialIndices;
@@ -21,7 +475,7 @@ std::vector<ProductTerm> PItable::solvePIMatrixAndMinimize(
         }
     }
 
-    if (remainingMinterms.empty()) {
+    if (remainingColumns.empty()) {
         return {}; // no more PIs needed
     }
     if (nonEssentialIndices.empty()) {
@@ -29,97 +483,421 @@ std::vector<ProductTerm> PItable::solvePIMatrixAndMinimize(
         return {};
     }
 
-    // POS (minterms*sums)
-    std::vector<BooleanExpression> sumTerms;
-
-    for (int minterm : remainingMinterms) {
-        BooleanExpression currentSum;
-        for (int pi_index : nonEssentialIndices) {
-            // checking if this non-essential PI covers the minterm
-            if (std::find(primes[pi_index].covered.begin(), primes[pi_index].covered.end(), minterm) != primes[pi_index].covered.end()) {
-                currentSum.push_back({pi_index}); // Add PI as a single-element ProductTerm
-            }
-        }
-        if (!currentSum.empty()) {
-            sumTerms.push_back(currentSum);
-        } else {
-            std::cerr << "Error: Minterm " << minterm << " is uncovered by non-essential PIs.\n";
+    // the sub-chart: the non-essential rows over the remaining columns
+    std::vector<std::vector<uint64_t>> rows = chart.subChart(nonEssentialIndices, remainingColumns);
+    std::vector<uint64_t> coveredByAny(rows.empty() ? 0 : rows[0].size(), 0);
+    for (const auto& row : rows)
+        for (size_t w = 0; w < row.size(); ++w) coveredByAny[w] |= row[w];
+    for (size_t c = 0; c < remainingColumns.size(); ++c) {
+        if (!((coveredByAny[c / 64] >> (c % 64)) & 1ULL)) {
+            std::cerr << "Error: Minterm " << chart.columnMinterms[(size_t)remainingColumns[c]] << " is uncovered by non-essential PIs.\n";
             return {};
         }
     }
 
-    // multipkying minterms sequentially
-    if (sumTerms.empty()) {
-        return {}; // ahould not happen if remainingMinterms is not empty
+    QM_PROFILE_APPEND("chart.rowsBeforeReduction", rows.size());
+    QM_PROFILE_APPEND("chart.columnsBeforeReduction", remainingColumns.size());
+    // shrink the chart to its cyclic core first (unless asked to keep every alternative)
+    ReducedChart core;
+    if (reduce) {
+        core = reduceChart(primes, nonEssentialIndices, remainingColumns, rows);
+    } else {
+        core.rowPIs = nonEssentialIndices;
+        core.columns = remainingColumns;
+        core.rows = std::move(rows);
     }
+    QM_PROFILE_APPEND("chart.rowsAfterReduction", core.rows.size());
+    QM_PROFILE_APPEND("chart.columnsAfterReduction", core.columns.size());
 
-    BooleanExpression finalExpression = sumTerms[0];
-
-    for (size_t i = 1; i < sumTerms.size(); ++i) {
-        finalExpression = multiplyExpressions(finalExpression, sumTerms[i]);
+    std::vector<ProductTerm> minimalSolutions;
+    if (core.columns.empty()) {
+        // the reduction alone covered everything
+        minimalSolutions.push_back(ProductTerm(core.secondaryEssentials.begin(), core.secondaryEssentials.end()));
+        return minimalSolutions;
     }
 
-    // 4. Find the minimal term(s) (fewest PIs)
-    size_t minSize = 1000;
-    for (const auto& term : finalExpression) {
-        if (term.size() < minSize) {
-            minSize = term.size();
+    bool solved = false;
+    if (mode == CoverMode::Petrick) {
+        minimalSolutions = solveByPetrick(core.rowPIs, core.rows, core.columns.size());
+        solved = true;
+    } else if (mode == CoverMode::PetrickTree) {
+        solved = solveByPetrickTree(core.rowPIs, core.rows, core.columns.size(), pool, memoryLimit, minimalSolutions);
+        if (!solved) {
+            std::cerr << "Note: Petrick's expression passed the memory limit (" << (memoryLimit >> 20)
+                      << " MB), solving the chart by branch and bound instead.\n";
         }
     }
-
-    // collect all minminal solutions
-    std::vector<ProductTerm> minimalSolutions;
-    for (const auto& term : finalExpression) {
-        if (term.size() == minSize) {
+    if (solved) {
+        if (maxSolutions != 0 && minimalSolutions.size() > maxSolutions) {
+            if (omitted != nullptr) *omitted = minimalSolutions.size() - maxSolutions;
+            minimalSolutions.resize(maxSolutions);
+        }
+    } else {
+        bool complete = true;
+        const std::vector<std::vector<int>> covers =
+            CoverSolver::minimumCovers(core.rows, core.columns.size(), maxSolutions, &complete, searchNodes, omitted);
+        if (covers.empty() && !complete) {
+            // the search for the minimum size ran out of searchNodes, the caller falls back
+            if (gaveUp != nullptr) *gaveUp = true;
+            return {};
+        }
+        for (const auto& cover : covers) {
+            ProductTerm term;
+            for (int r : cover) term.insert(core.rowPIs[r]);
             minimalSolutions.push_back(term);
         }
+        // covers cut by maxSolutions are the caller's to report (omitted), with this in them
+        if (!complete && (omitted == nullptr || *omitted == 0)) {
+            std::cerr << "Note: the chart has more minimum covers than listed (" << minimalSolutions.size()
+                      << " shown, all of the same minimum size).\n";
+        }
     }
 
+    // every solution of the core also needs the PIs the reduction already picked
+    for (auto& term : minimalSolutions)
+        term.insert(core.secondaryEssentials.begin(), core.secondaryEssentials.end());
     return minimalSolutions;
 }
 
-BooleanExpression PItable::multiplyExpressions(const BooleanExpression& exp1,
-                                     const BooleanExpression& exp2) {
-    BooleanExpression result;
+// Chart reduction. Each round:
+//  1. a minterm covered by a single PI makes that PI (secondary) essential: pick it and drop
+//     every minterm it covers,
+//  2. a PI whose minterms are a subset of another PI's, with no fewer literals, is dropped
+//     (ties keep the lower index),
+//  3. a minterm whose PIs are a superset of another minterm's PIs is dropped, since covering
+//     the other one covers it too (ties keep the lower index).
+// Rounds repeat until nothing changes. Steps 1 and 3 keep every minimum cover; step 2 keeps at
+// least one per cost, so solvePIMatrixAndMinimize only runs it with reduce=true (--reduce).
+// Steps 2 and 3 are skipped on charts too big to compare every pair (kMaxDominanceWords).
+ReducedChart PItable::reduceChart(
+    const std::vector<Implicant>& primes,
+    const std::vector<int>& rowPIs,
+    const std::vector<int>& columns,
+    const std::vector<std::vector<uint64_t>>& rows
+) {
+    QM_PROFILE_TIMER("reduceChart");
+    const size_t rowCount = rows.size();
+    const size_t columnCount = columns.size();
+    const size_t words = (columnCount + 63) / 64;
+    const size_t rowWords = (rowCount + 63) / 64;
+
+    std::vector<uint64_t> liveColumns(words, ~0ULL);
+    if (columnCount % 64) liveColumns[words - 1] = (1ULL << (columnCount % 64)) - 1ULL;
+    std::vector<char> liveRow(rowCount, 1);
+
+    // R^2 / C^2 pairs of bit rows: on a huge chart only the secondary essentials are taken
+    const bool rowDominance = (double)rowCount * (double)rowCount * (double)words <= kMaxDominanceWords;
+    const bool columnDominance = (double)columnCount * (double)columnCount * (double)rowWords <= kMaxDominanceWords;
+
+    ReducedChart result;
+    auto rowIsEmpty = [&](size_t r) {
+        for (size_t w = 0; w < words; ++w)
+            if (rows[r][w] & liveColumns[w]) return false;
+        return true;
+    };
+    // live columns of row a are a subset of those of row b
+    auto rowSubset = [&](size_t a, size_t b) {
+        for (size_t w = 0; w < words; ++w)
+            if (rows[a][w] & liveColumns[w] & ~rows[b][w]) return false;
+        return true;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        // columns as bit sets over the live rows
+        std::vector<std::vector<uint64_t>> columnBits(columnCount, std::vector<uint64_t>(rowWords, 0));
+        for (size_t r = 0; r < rowCount; ++r) {
+            if (!liveRow[r]) continue;
+            for (size_t c = 0; c < columnCount; ++c)
+                if ((rows[r][c / 64] >> (c % 64)) & 1ULL)
+                    columnBits[c][r / 64] |= 1ULL << (r % 64);
+        }
+
+        // 1. secondary essentials
+        for (size_t c = 0; c < columnCount; ++c) {
+            if (!((liveColumns[c / 64] >> (c % 64)) & 1ULL)) continue;
+            int count = 0;
+            size_t only = 0;
+            for (size_t w = 0; w < rowWords; ++w) {
+                count += popcount64(columnBits[c][w]);
+                if (columnBits[c][w]) only = w * 64 + (size_t)__builtin_ctzll(columnBits[c][w]);
+            }
+            if (count != 1 || !liveRow[only]) continue; // rows picked this round are handled below
+            result.secondaryEssentials.push_back(rowPIs[only]);
+            liveRow[only] = 0;
+            for (size_t w = 0; w < words; ++w) liveColumns[w] &= ~rows[only][w];
+            changed = true;
+        }
+        if (changed) {
+            for (size_t r = 0; r < rowCount; ++r)
+                if (liveRow[r] && rowIsEmpty(r)) liveRow[r] = 0;
+            continue; // rebuild the columns before comparing anything
+        }
+
+        // 2. dominated rows
+        for (size_t r = 0; r < rowCount; ++r) {
+            if (!liveRow[r]) continue;
+            if (rowIsEmpty(r)) {
+                liveRow[r] = 0;
+                changed = true;
+                continue;
+            }
+            if (!rowDominance) continue;
+            int costR = primes[rowPIs[r]].cube.literalCount();
+            for (size_t s = 0; s < rowCount; ++s) {
+                if (s == r || !liveRow[s]) continue;
+                if (!rowSubset(r, s)) continue;
+                int costS = primes[rowPIs[s]].cube.literalCount();
+                if (costS > costR) continue;
+                if (costS == costR && rowSubset(s, r) && s > r) continue; // identical: keep the lower index
+                liveRow[r] = 0;
+                changed = true;
+                break;
+            }
+        }
+        if (changed) continue;
+
+        // 3. dominating columns
+        for (size_t c = 0; columnDominance && c < columnCount; ++c) {
+            if (!((liveColumns[c / 64] >> (c % 64)) & 1ULL)) continue;
+            for (size_t d = 0; d < columnCount; ++d) {
+                if (d == c || !((liveColumns[d / 64] >> (d % 64)) & 1ULL)) continue;
+                // rows(d) must be a subset of rows(c)
+                bool subset = true;
+                bool equal = true;
+                for (size_t w = 0; w < rowWords; ++w) {
+                    if (columnBits[d][w] & ~columnBits[c][w]) { subset = false; break; }
+                    if (columnBits[d][w] != columnBits[c][w]) equal = false;
+                }
+                if (!subset || (equal && d > c)) continue;
+                liveColumns[c / 64] &= ~(1ULL << (c % 64));
+                changed = true;
+                break;
+            }
+        }
+    }
 
-    for (const auto& term1 : exp1) {
-        for (const auto& term2 : exp2) {
-            ProductTerm new_term = term1;
-            new_term.insert(term2.begin(), term2.end());
-            result.push_back(new_term);
+    // compact what is left into the core chart
+    std::vector<size_t> keptColumns;
+    for (size_t c = 0; c < columnCount; ++c)
+        if ((liveColumns[c / 64] >> (c % 64)) & 1ULL) {
+            keptColumns.push_back(c);
+            result.columns.push_back(columns[c]);
         }
+    size_t coreWords = (keptColumns.size() + 63) / 64;
+    for (size_t r = 0; r < rowCount; ++r) {
+        if (!liveRow[r]) continue;
+        std::vector<uint64_t> row(coreWords, 0);
+        for (size_t k = 0; k < keptColumns.size(); ++k)
+            if ((rows[r][keptColumns[k] / 64] >> (keptColumns[k] % 64)) & 1ULL)
+                row[k / 64] |= 1ULL << (k % 64);
+        result.rowPIs.push_back(rowPIs[r]);
+        result.rows.push_back(std::move(row));
     }
+    sort(result.secondaryEssentials.begin(), result.secondaryEssentials.end());
+    return result;
+}
 
-    // simplifying via absorption law
-    return simplifyExpression(result);
+// Petrick's method: one sum per minterm (column), multiplied out and simplified by absorption.
+// Terms are bit rows over the chart rows. Multiplying an absorbed expression E by a sum S:
+//  - a term of E that already has a PI of S is unchanged (the other products contain it),
+//  - a term t without one becomes t+x for every x of S. Such a product is distinct from every
+//    other one, and the only terms that can absorb it are terms of E whose PIs in S are just {x},
+//    with at most |t| PIs, so those are bucketed by x and by size.
+// The sums themselves are absorbed first (a minterm whose PIs include another minterm's adds
+// nothing) and multiplied in clusterSums order. Products that can't grow into a cover of at most
+// `bound` PIs are dropped (withinBound). The bound starts at the number of disjoint sums, which
+// every cover needs, and goes up by one while nothing is left, up to a greedy cover's size: the
+// first bound that leaves a term is the minimum size, and every minimum cover is kept.
+std::vector<ProductTerm> PItable::solveByPetrick(
+    const std::vector<int>& rowPIs,
+    const std::vector<std::vector<uint64_t>>& rows,
+    size_t columnCount
+) {
+    const size_t width = std::max<size_t>((rows.size() + 63) / 64, 1);
+
+    // POS (minterms*sums), each sum a bit row over the chart rows
+    TermTable sums(width);
+    if (!buildSums(rows, columnCount, sums)) return {};
+    if (sums.size() == 0) {
+        return {}; // ahould not happen if there are columns left
+    }
+    sums = absorb(sums); // smallest sums first keeps the expression small
+    const int greedy = greedyCoverSize(rows, columnCount);
+
+    // multiplying the sums in, starting from the empty product
+    const std::vector<size_t> order = clusterSums(sums);
+    TermTable expression(width);
+    int bound = std::min((int)disjointSums(sums, std::vector<char>(sums.size(), 0)).size(), greedy);
+    while (true) {
+        multiplySums(sums, order, bound, expression);
+        QM_PROFILE_ADD("petrick.passes", 1);
+        if (expression.size() != 0 || bound >= greedy) break;
+        ++bound;
+    }
+
+    // collect all minminal solutions (fewest PIs), ordered by their PI indices
+    return smallestTerms(expression, rowPIs);
 }
 
-BooleanExpression PItable::simplifyExpression(const BooleanExpression& exp) {
-    BooleanExpression simplified_exp;
-
-    // sorting by size to check shortest first so its faster
-    std::vector<ProductTerm> sorted_exp = exp;
-    std::sort(sorted_exp.begin(), sorted_exp.end(),
-              [](const ProductTerm& a, const ProductTerm& b) {
-                  return a.size() < b.size();
-              });
-
-    for (size_t i = 0; i < sorted_exp.size(); ++i) {
-        bool is_absorbed = false;
-        //check if sorted_exp[i] is absorbed by any preceding, shorter term
-        for (size_t j = 0; j < i; ++j) {
-            // includes checks if sorted_exp[j] is a subset of sorted_exp[i]
-            if (std::includes(sorted_exp[i].begin(), sorted_exp[i].end(),
-                              sorted_exp[j].begin(), sorted_exp[j].end())) {
-
-                is_absorbed = true;
-                break;
-                              }
+// Tree Petrick: the sums, ordered by clusterSums, are the leaves of a balanced binary tree, one
+// sum each (its PIs as one-PI terms). Every level multiplies neighbouring pairs, as separate pool
+// tasks for the small levels and split inside the node for the big ones, and absorbs every
+// product right away, so no sum is ever multiplied into a long left-to-right chain.
+// A part of the tree misses the absorption by the sums of the other parts, so it prunes with
+// the exact minimum size (one cover from the branch and bound) and with the disjoint sums of
+// the other parts (withinBound); the root has no other part and keeps every minimum cover.
+// The memory budget is checked in every node and after every level.
+bool PItable::solveByPetrickTree(
+    const std::vector<int>& rowPIs,
+    const std::vector<std::vector<uint64_t>>& rows,
+    size_t columnCount,
+    ThreadPool* pool,
+    size_t memoryLimit,
+    std::vector<ProductTerm>& solutions
+) {
+    solutions.clear();
+    const size_t width = std::max<size_t>((rows.size() + 63) / 64, 1);
+    TermTable sums(width);
+    if (!buildSums(rows, columnCount, sums)) return true;
+    if (sums.size() == 0) return true;
+    sums = absorb(sums);
+    const std::vector<std::vector<int>> one = CoverSolver::minimumCovers(rows, columnCount, 1);
+    const int bound = one.empty() ? greedyCoverSize(rows, columnCount) : (int)one[0].size();
+
+    MemoryBudget budget;
+    budget.limit = memoryLimit;
+    const std::vector<size_t> order = clusterSums(sums);
+    // part of the tree = a range of positions in order
+    std::vector<std::pair<size_t, size_t>> ranges(order.size());
+    for (size_t i = 0; i < order.size(); ++i) ranges[i] = {i, i + 1};
+    auto outsideOf = [&](std::pair<size_t, size_t> range) {
+        std::vector<char> inPart(sums.size(), 0);
+        for (size_t i = range.first; i < range.second; ++i) inPart[order[i]] = 1;
+        return disjointSums(sums, inPart);
+    };
+
+    std::vector<TermTable> level(order.size(), TermTable(width));
+    auto leaf = [&](size_t i) {
+        const uint64_t* S = sums.term(order[i]);
+        const TermTable outside = outsideOf(ranges[i]);
+        std::vector<uint64_t> single(width);
+        for (size_t w = 0; w < width; ++w) {
+            for (uint64_t bits = S[w]; bits; bits &= bits - 1) {
+                std::fill(single.begin(), single.end(), 0);
+                single[w] = bits & (~bits + 1);
+                if (withinBound(single.data(), 1, bound, &outside)) level[i].push(single.data(), 1);
+            }
         }
+        budget.add(tableBytes(level[i]));
+    };
+    if (pool && pool->size() > 1) pool->run(order.size(), leaf);
+    else for (size_t i = 0; i < order.size(); ++i) leaf(i);
 
-        if (!is_absorbed) {
-            simplified_exp.push_back(sorted_exp[i]);
+    QM_PROFILE_ONLY(size_t nodes = 0;)
+    while (level.size() > 1 && !budget.exceeded) {
+        std::vector<TermTable> next((level.size() + 1) / 2, TermTable(width));
+        std::vector<std::pair<size_t, size_t>> nextRanges(next.size());
+        const size_t pairs = level.size() / 2;
+        auto node = [&](size_t p) {
+            nextRanges[p] = {ranges[2 * p].first, ranges[2 * p + 1].second};
+            if (budget.exceeded) return;
+            const TermTable outside = outsideOf(nextRanges[p]);
+            if (multiplyNode(level[2 * p], level[2 * p + 1], bound, &outside, pool, budget, next[p])) {
+                budget.release(tableBytes(level[2 * p]) + tableBytes(level[2 * p + 1]));
+                level[2 * p] = TermTable(width);
+                level[2 * p + 1] = TermTable(width);
+            }
+        };
+        if (pool && pairs > 1) pool->run(pairs, node);
+        else for (size_t p = 0; p < pairs; ++p) node(p);
+        if (level.size() % 2) {
+            next.back() = std::move(level.back());
+            nextRanges.back() = ranges.back();
         }
+        QM_PROFILE_ONLY(nodes += pairs;)
+        level = std::move(next);
+        ranges = std::move(nextRanges);
     }
-    return simplified_exp;
-}
\ No newline at end of file
+    QM_PROFILE_ADD("petrick.treeNodes", nodes);
+    QM_PROFILE_APPEND("petrick.treePeakBytes", budget.peak.load());
+    if (budget.exceeded) return false;
+    solutions = smallestTerms(level[0], rowPIs);
+    return true;
+}
+
+// Multi-output: which of the selected PIs each output ORs together. A PI goes to every output
+// in its mask where it covers a minterm; then, per output, PIs whose minterms are all covered
+// by the others are dropped, the ones with the most literals first. With one output a minimum
+// cover is already irredundant, so this is just the selection.
+std::vector<std::vector<int>> PItable::outputTerms(
+    const std::vector<Implicant>& primes,
+    const PIChart& chart,
+    const std::vector<int>& selected
+) {
+    std::vector<std::vector<int>> perOutput(chart.outputCount);
+    for (size_t o = 0; o < chart.outputCount; ++o) {
+        const size_t begin = chart.outputStart[o];
+        const size_t end = chart.outputStart[o + 1];
+        std::vector<int> candidates;
+        std::vector<int> coverCount(end - begin, 0);
+        for (int r : selected) {
+            bool any = false;
+            for (size_t c = begin; c < end; ++c) {
+                if (!chart.covers((size_t)r, c)) continue;
+                ++coverCount[c - begin];
+                any = true;
+            }
+            if (any) candidates.push_back(r);
+        }
+
+        std::vector<int> order = candidates;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return primes[(size_t)a].cube.literalCount() > primes[(size_t)b].cube.literalCount();
+        });
+        std::unordered_set<int> dropped;
+        for (int r : order) {
+            bool needed = false;
+            for (size_t c = begin; c < end && !needed; ++c)
+                needed = chart.covers((size_t)r, c) && coverCount[c - begin] == 1;
+            if (needed) continue;
+            dropped.insert(r);
+            for (size_t c = begin; c < end; ++c)
+                if (chart.covers((size_t)r, c)) --coverCount[c - begin];
+        }
+        for (int r : candidates)
+            if (!dropped.count(r)) perOutput[o].push_back(r);
+    }
+    return perOutput;
+}
+
+// the two helpers below work on ProductTerms for any expressions; solveByPetrick has its own
+// loop over the bit rows
+BooleanExpression PItable::multiplyExpressions(const BooleanExpression& exp1,
+                                     const BooleanExpression& exp2) {
+    BooleanExpression both = exp1;
+    both.insert(both.end(), exp2.begin(), exp2.end());
+    std::vector<int> indices;
+    TermTable table = toTable(both, indices);
+    TermTable result(table.width);
+    std::vector<uint64_t> product(table.width);
+    for (size_t i = 0; i < exp1.size(); ++i) {
+        for (size_t j = exp1.size(); j < both.size(); ++j) {
+            for (size_t w = 0; w < table.width; ++w) product[w] = table.term(i)[w] | table.term(j)[w];
+            result.push(product.data(), countBits(product.data(), table.width));
+        }
+    }
+
+    // simplifying via absorption law
+    TermTable simplified = absorb(result);
+    QM_PROFILE_APPEND("petrick.termsBeforeAbsorption", result.size());
+    QM_PROFILE_APPEND("petrick.termsAfterAbsorption", simplified.size());
+    return fromTable(simplified, indices);
+}
+
+BooleanExpression PItable::simplifyExpression(const BooleanExpression& exp) {
+    std::vector<int> indices;
+    return fromTable(absorb(toTable(exp, indices)), indices);
+}
@@ -7,15 +7,41 @@
 
 #include <set>
 #include <unordered_set>
+#include "CoverSolver.h"
 #include "Implicant.h"
+#include "PIChart.h"
 
 using ProductTerm = std::set<int>;
 using BooleanExpression = std::vector<ProductTerm>;
 
+// the part of the PI chart that is still cyclic after reduceChart
+struct ReducedChart {
+    std::vector<int> rowPIs;                   // prime index of each remaining row
+    std::vector<int> columns;                  // chart column of each remaining column
+    std::vector<std::vector<uint64_t>> rows;   // bit rows over the remaining columns
+    std::vector<int> secondaryEssentials;      // PIs picked while reducing
+};
+
+class ThreadPool;
 
 class PItable {
 public:
-    static std::vector<ProductTerm> solvePIMatrixAndMinimize(const std::vector<Implicant>& primes,const std::vector<int>& essential, const std::vector<int>& remainingMinterms);
+    // maxSolutions != 0 stops listing minimum covers after that many. reduce runs reduceChart
+    // first (faster, but only one minimum cover per cost, like --reduce). PetrickTree multiplies on
+    // pool (inline without one) and switches to branch and bound when its expressions would pass
+    // memoryLimit bytes (0 = no limit). searchNodes != 0 is the branch and bound's budget for
+    // finding the minimum size: past it nothing is returned and *gaveUp is set. omitted gets the
+    // number of minimum covers left out by maxSolutions (as far as the solver looked)
+    static std::vector<ProductTerm> solvePIMatrixAndMinimize(const std::vector<Implicant>& primes, const PIChart& chart, const std::vector<int>& essential, const std::vector<int>& remainingColumns, CoverMode mode = CoverMode::BranchAndBound, bool reduce = false, size_t maxSolutions = 0, ThreadPool* pool = nullptr, size_t memoryLimit = 0, size_t searchNodes = 0, bool* gaveUp = nullptr, size_t* omitted = nullptr);
+    // repeats essential extraction, dominated-PI removal and dominating-minterm removal until the chart stops changing
+    static ReducedChart reduceChart(const std::vector<Implicant>& primes, const std::vector<int>& rowPIs, const std::vector<int>& columns, const std::vector<std::vector<uint64_t>>& rows);
+    // reference solver: multiplies out the whole product of sums (exponential, small charts only)
+    static std::vector<ProductTerm> solveByPetrick(const std::vector<int>& rowPIs, const std::vector<std::vector<uint64_t>>& rows, size_t columnCount);
+    // the same product multiplied as a balanced binary tree, the levels on the pool; false (and no
+    // solutions) when the terms alive at once would take more than about memoryLimit bytes
+    static bool solveByPetrickTree(const std::vector<int>& rowPIs, const std::vector<std::vector<uint64_t>>& rows, size_t columnCount, ThreadPool* pool, size_t memoryLimit, std::vector<ProductTerm>& solutions);
+    // multi-output: the selected PIs (EPIs + a solution) each output uses, output by output
+    static std::vector<std::vector<int>> outputTerms(const std::vector<Implicant>& primes, const PIChart& chart, const std::vector<int>& selected);
 // the following are helper functions to help simpligy the boolean expression we reached
     static BooleanExpression multiplyExpressions(const BooleanExpression& exp1, const BooleanExpression& exp2);
     static BooleanExpression simplifyExpression(const BooleanExpression& exp);
@@ -0,0 +1,434 @@
+//
+// Berkeley PLA reader / writer and the minimization of a PLA's cubes (see Pla.h).
+//
+
+#include "Pla.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "CubeIndex.h"
+#include "Profile.h"
+
+namespace {
+
+// size of the read buffer, and how much the writer collects before it writes
+constexpr size_t kChunkBytes = 64 * 1024;
+
+// an exact run lists the on-set points as chart columns; past this many the PLA goes to the
+// heuristic instead
+constexpr double kMaxChartPoints = 1 << 24;
+// the chart itself is one bit per PI and column: past this many bytes the PLA goes to the
+// heuristic too (known only once the primes are out)
+constexpr double kMaxChartBytes = 1 << 28;
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+// points of a cube over nbVars variables (as a double, a 64-variable cube has 2^64)
+inline double points(const Cube& c, int nbVars) { return std::ldexp(1.0, nbVars - c.literalCount()); }
+
+// the cover of output o in a solution, as Verifier::checkResult reads it
+vector<Cube> solutionCover(const MinimizationResult& result, size_t s, size_t o) {
+    vector<Cube> cover;
+    if (result.outputCount > 1) {
+        if (s < result.outputSelections.size() && o < result.outputSelections[s].size())
+            for (int idx : result.outputSelections[s][o]) cover.push_back(result.primes[(size_t)idx].cube);
+        return cover;
+    }
+    for (int idx : result.essential) cover.push_back(result.primes[(size_t)idx].cube);
+    if (s < result.solutions.size())
+        for (int idx : result.solutions[s]) cover.push_back(result.primes[(size_t)idx].cube);
+    return cover;
+}
+
+// cover (output o of a solution) holds o's on-set and stays inside on-set + don't cares
+bool checkCover(const PlaFunction& function, size_t o, Cover cover, const std::string& where, std::string& error) {
+    const int n = function.nbVars;
+    const Cover onSet = function.onSet(o);
+    const Cover dontCares = function.dontCares(o);
+    Cover care = onSet;
+    care.insert(care.end(), dontCares.begin(), dontCares.end());
+    for (const Cube& c : cover)
+        if (!Espresso::covers(care, c, n)) {
+            error = where + "product term " + c.toPattern(n) + " has a point of the off-set";
+            return false;
+        }
+    cover.insert(cover.end(), dontCares.begin(), dontCares.end());
+    for (const Cube& c : onSet)
+        if (!Espresso::covers(cover, c, n)) {
+            error = where + "on-set cube " + c.toPattern(n) + " is not covered";
+            return false;
+        }
+    return true;
+}
+
+// Engine::Auto for a PLA: FileManip::autoPicksExact's limits on the lines (what a term is to a
+// function file), the neighbours being the lines of a shared output at most one variable apart
+// (the pairs the consensus works on). The on-set points become the chart's columns, so they are
+// capped as well (except in a space small enough to be always exact).
+bool autoPicksExact(const PlaFunction& function, double onPoints) {
+    if (function.nbVars <= kAutoExactVars) return true;
+    if (onPoints > (double)kAutoMaxExactTerms) return false;
+    const vector<Implicant>& cubes = function.cubes;
+    if (cubes.size() <= kAutoExactTerms) return true;
+    if (cubes.size() > kAutoMaxExactTerms) return false;
+    const double most = kAutoExactDegree * (double)cubes.size();
+    double neighbours = 0;
+    for (size_t a = 0; a < cubes.size(); ++a)
+        for (size_t b = a + 1; b < cubes.size(); ++b) {
+            if (!(cubes[a].outputs & cubes[b].outputs)) continue;
+            const Cube& x = cubes[a].cube;
+            const Cube& y = cubes[b].cube;
+            if (popcount64((x.value ^ y.value) & x.mask & y.mask) > 1) continue;
+            neighbours += 2;
+            if (neighbours > most) return false;
+        }
+    return true;
+}
+
+} // namespace
+
+Cover PlaFunction::onSet(size_t o) const {
+    Cover cover;
+    for (const Implicant& imp : cubes)
+        if (!imp.isPureDontCare && ((imp.outputs >> o) & 1ULL)) cover.push_back(imp.cube);
+    return cover;
+}
+
+Cover PlaFunction::dontCares(size_t o) const {
+    Cover cover;
+    for (const Implicant& imp : cubes)
+        if (imp.isPureDontCare && ((imp.outputs >> o) & 1ULL)) cover.push_back(imp.cube);
+    return cover;
+}
+
+PlaReader::PlaReader(std::istream& in) : in_(in), buffer_(kChunkBytes) {}
+
+bool PlaReader::fail(const std::string& message) {
+    error_ = "Error: line " + to_string(lineNumber_) + ": " + message;
+    return false;
+}
+
+// the next line without its '\n'; a line cut by the end of the buffer is carried over in `line`
+// while the next chunk is read, so only the longest line has to fit anywhere
+bool PlaReader::readLine(std::string& line) {
+    line.clear();
+    while (true) {
+        const char* start = buffer_.data() + begin_;
+        const char* stop = (const char*)memchr(start, '\n', end_ - begin_);
+        if (stop != nullptr) {
+            line.append(start, stop);
+            begin_ = (size_t)(stop - buffer_.data()) + 1;
+            ++lineNumber_;
+            return true;
+        }
+        line.append(start, end_ - begin_);
+        begin_ = end_ = 0;
+        if (eof_) {
+            if (line.empty()) return false;
+            ++lineNumber_;
+            return true;
+        }
+        in_.read(buffer_.data(), (std::streamsize)buffer_.size());
+        end_ = (size_t)in_.gcount();
+        if (end_ < buffer_.size()) eof_ = true;
+    }
+}
+
+bool PlaReader::keyword(const std::string& line) {
+    std::istringstream words(line);
+    std::string key;
+    words >> key;
+    if (key == ".i" || key == ".o") {
+        long long count = 0;
+        if (!(words >> count) || count < 1 || count > 64) return fail(key + " expects a number from 1 to 64");
+        if (sawCube_) return fail(key + " after the first cube");
+        if (key == ".i") nbVars_ = (int)count;
+        else outputCount_ = (size_t)count;
+    } else if (key == ".ilb" || key == ".ob") {
+        std::vector<std::string>& names = (key == ".ilb") ? inputNames_ : outputNames_;
+        names.clear();
+        for (std::string name; words >> name;) names.push_back(name);
+    } else if (key == ".type") {
+        words >> type_;
+        if (type_ != "f" && type_ != "fd" && type_ != "fr" && type_ != "fdr" && type_ != "r" && type_ != "dr")
+            return fail(".type expects f, fd, fr, fdr, r or dr");
+    } else if (key == ".e" || key == ".end") {
+        done_ = true;
+    } else if (key != ".p") { // .p is only a hint, the cubes are counted as they come
+        return fail("unsupported keyword " + key);
+    }
+    return true;
+}
+
+bool PlaReader::next(Cube& cube, uint64_t& on, uint64_t& dontCare, uint64_t& off) {
+    while (!done_ && readLine(line_)) {
+        const size_t comment = line_.find('#');
+        if (comment != std::string::npos) line_.resize(comment);
+        size_t first = 0;
+        while (first < line_.size() && isSpace(line_[first])) ++first;
+        if (first == line_.size()) continue;
+        if (line_[first] == '.') {
+            if (!keyword(line_.substr(first))) return false;
+            continue;
+        }
+        if (!sawCube_) {
+            if (nbVars_ < 0) return fail(".i must come before the first cube");
+            if (!inputNames_.empty() && inputNames_.size() != (size_t)nbVars_) return fail(".ilb doesn't have .i names");
+            if (!outputNames_.empty() && outputNames_.size() != outputCount_) return fail(".ob doesn't have .o names");
+            sawCube_ = true;
+        }
+
+        cube = Cube();
+        on = dontCare = off = 0;
+        const size_t columns = (size_t)nbVars_ + outputCount_;
+        size_t column = 0;
+        for (size_t k = first; k < line_.size(); ++k) {
+            const char c = line_[k];
+            if (isSpace(c) || c == '|') continue;
+            if (column == columns) return fail("more than " + to_string(columns) + " columns");
+            if (column < (size_t)nbVars_) {
+                // the first column is variable A, the highest bit (as in Cube::toPattern)
+                const uint64_t bit = 1ULL << ((size_t)nbVars_ - 1 - column);
+                if (c == '0' || c == '1') cube.mask |= bit;
+                if (c == '1') cube.value |= bit;
+                else if (c != '0' && c != '-' && c != '2') return fail(std::string("bad input column '") + c + "'");
+            } else {
+                const uint64_t bit = 1ULL << (column - (size_t)nbVars_);
+                if (c == '1' || c == '4') on |= bit;
+                else if (c == '-' || c == '2') dontCare |= bit;
+                else if (c == '0') off |= bit;
+                else if (c != '~') return fail(std::string("bad output column '") + c + "'");
+            }
+            ++column;
+        }
+        if (column != columns) return fail("expected " + to_string(columns) + " columns, got " + to_string(column));
+        return true;
+    }
+    if (in_.bad()) fail("read error");
+    return false;
+}
+
+PlaWriter::PlaWriter(std::ostream& out, int nbVars, size_t outputCount, size_t cubeCount,
+                     const std::vector<std::string>& inputNames, const std::vector<std::string>& outputNames)
+    : out_(out), nbVars_(nbVars), outputCount_(outputCount) {
+    buffer_.reserve(kChunkBytes + 256);
+    buffer_ += ".i " + to_string(nbVars) + "\n.o " + to_string(outputCount) + "\n";
+    if (!inputNames.empty()) {
+        buffer_ += ".ilb";
+        for (const std::string& name : inputNames) buffer_ += " " + name;
+        buffer_ += "\n";
+    }
+    if (!outputNames.empty()) {
+        buffer_ += ".ob";
+        for (const std::string& name : outputNames) buffer_ += " " + name;
+        buffer_ += "\n";
+    }
+    buffer_ += ".type f\n.p " + to_string(cubeCount) + "\n";
+}
+
+void PlaWriter::write(const Cube& cube, uint64_t outputs) {
+    for (int i = nbVars_ - 1; i >= 0; --i) {
+        const uint64_t bit = 1ULL << i;
+        buffer_ += (cube.mask & bit) ? ((cube.value & bit) ? '1' : '0') : '-';
+    }
+    buffer_ += ' ';
+    for (size_t o = 0; o < outputCount_; ++o) buffer_ += ((outputs >> o) & 1ULL) ? '1' : '0';
+    buffer_ += '\n';
+    if (buffer_.size() >= kChunkBytes) flush();
+}
+
+void PlaWriter::flush() {
+    out_.write(buffer_.data(), (std::streamsize)buffer_.size());
+    buffer_.clear();
+}
+
+bool PlaWriter::finish() {
+    buffer_ += ".e\n";
+    flush();
+    out_.flush();
+    return (bool)out_;
+}
+
+bool Pla::read(std::istream& in, PlaFunction& function, std::string& error) {
+    QM_PROFILE_TIMER("Pla::read");
+    function = PlaFunction();
+    PlaReader reader(in);
+    bool useOn = true, useDontCares = true, useOff = false;
+    std::vector<Cover> offSets;
+    auto add = [&](const Cube& cube, uint64_t outputs, bool dontCare) {
+        Implicant imp;
+        imp.cube = cube;
+        imp.outputs = outputs;
+        imp.isPureDontCare = dontCare;
+        function.cubes.push_back(std::move(imp));
+    };
+
+    Cube cube;
+    uint64_t on = 0, dontCare = 0, off = 0;
+    bool first = true;
+    while (reader.next(cube, on, dontCare, off)) {
+        if (first) {
+            first = false;
+            // the keywords are all in by the first cube
+            const std::string& type = reader.type();
+            useOn = type.find('f') != std::string::npos;
+            useDontCares = type.find('d') != std::string::npos;
+            // with f and d both given the off-set adds nothing
+            useOff = type.find('r') != std::string::npos && !(useOn && useDontCares);
+            if (useOff) offSets.resize(reader.outputCount());
+        }
+        if (useOn && on != 0) add(cube, on, false);
+        if (useDontCares && dontCare != 0) add(cube, dontCare, true);
+        if (useOff)
+            for (uint64_t bits = off; bits != 0; bits &= bits - 1) offSets[(size_t)__builtin_ctzll(bits)].push_back(cube);
+    }
+    if (!reader.error().empty()) {
+        error = reader.error();
+        return false;
+    }
+    if (reader.nbVars() < 0) {
+        error = "Error: no .i line (number of inputs)";
+        return false;
+    }
+    function.nbVars = reader.nbVars();
+    function.outputCount = reader.outputCount();
+    function.inputNames = reader.inputNames();
+    function.outputNames = reader.outputNames();
+
+    // fr: the don't cares are what is neither on nor off; r / dr: the on-set is what is neither
+    // off nor a don't care
+    if (useOff) {
+        for (size_t o = 0; o < function.outputCount; ++o) {
+            Cover given = offSets[o];
+            for (const Cube& c : useOn ? function.onSet(o) : function.dontCares(o)) given.push_back(c);
+            for (const Cube& c : Espresso::complement(given)) add(c, 1ULL << o, useOn);
+        }
+    }
+    return true;
+}
+
+bool Pla::load(const std::string& filePath, PlaFunction& function, std::string& error) {
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in) {
+        error = "Error: file not found: " + filePath;
+        return false;
+    }
+    return read(in, function, error);
+}
+
+MinimizationResult Pla::minimize(const PlaFunction& function, const RunOptions& options, ThreadPool* pool) {
+    QM_PROFILE_TIMER("Pla::minimize");
+    const int n = function.nbVars;
+    // on-set points per output, overlaps counted twice (an upper bound on the chart's columns)
+    double onPoints = 0;
+    for (const Implicant& imp : function.cubes)
+        if (!imp.isPureDontCare) onPoints += points(imp.cube, n) * popcount64(imp.outputs);
+    bool heuristic = options.engine == Engine::Heuristic ||
+                     (options.engine == Engine::Auto && !autoPicksExact(function, onPoints));
+    if (!heuristic && onPoints > kMaxChartPoints) {
+        cerr << "Note: the on-set has about " << onPoints << " points, too many for the exact chart, using the heuristic.\n";
+        heuristic = true;
+    }
+
+    MinimizationResult result;
+    if (!heuristic) {
+        // the chart's columns: every on-set point that isn't also a don't care
+        std::vector<std::vector<Term>> minterms(function.outputCount);
+        size_t columns = 0;
+        for (size_t o = 0; o < function.outputCount; ++o) {
+            // a point is a don't care when a dc cube covers it: one lookup, not a pass over them
+            const Cover dontCares = function.dontCares(o);
+            CubeIndex dcIndex(n);
+            for (size_t k = 0; k < dontCares.size(); ++k) dcIndex.insert(dontCares[k], (uint32_t)k);
+            for (const Cube& c : function.onSet(o)) {
+                const uint64_t freeBits = Cube::fullMask(n) & ~c.mask;
+                uint64_t sub = 0;
+                do {
+                    const Term t = c.value | sub;
+                    const bool dontCare = dcIndex.find(Cube::fromTerm(t, n), CubeIndex::Covering, [](uint32_t) { return true; });
+                    if (!dontCare) minterms[o].push_back(t);
+                    sub = (sub - freeBits) & freeBits; // next subset of the free bits
+                } while (sub != 0);
+            }
+            sort(minterms[o].begin(), minterms[o].end());
+            minterms[o].erase(unique(minterms[o].begin(), minterms[o].end()), minterms[o].end());
+            columns += minterms[o].size();
+        }
+        result.outputCount = function.outputCount;
+        result.primes = Implicant::generatePrimeImplicants(function.cubes, n, pool);
+        const double chartBytes = (double)result.primes.size() * (double)columns / 8;
+        if (chartBytes > kMaxChartBytes) {
+            cerr << "Note: the PI chart would be " << result.primes.size() << " PIs x " << columns << " points (about "
+                 << (size_t)(chartBytes / (1 << 20)) << " MB), too big for the exact cover, using the heuristic.\n";
+            heuristic = true;
+            result = MinimizationResult();
+        } else if (!FileManip::solveChart(result, minterms, n, options, pool, false)) {
+            heuristic = true;
+            result = MinimizationResult();
+        }
+    }
+    if (heuristic) {
+        std::vector<Cover> covers;
+        for (size_t o = 0; o < function.outputCount; ++o)
+            covers.push_back(Espresso::minimize(n, function.onSet(o), function.dontCares(o)));
+        result = FileManip::heuristicResult(covers, n, false);
+    }
+    if (options.verify && !checkResult(function, result, result.verifyError)) cerr << result.verifyError << "\n";
+    return result;
+}
+
+bool Pla::checkResult(const PlaFunction& function, const MinimizationResult& result, std::string& error) {
+    QM_PROFILE_TIMER("verify");
+    const size_t solutionCount = std::max<size_t>(result.outputCount > 1 ? result.outputSelections.size() : result.solutions.size(), 1);
+    for (size_t o = 0; o < function.outputCount; ++o)
+        for (size_t s = 0; s < solutionCount; ++s) {
+            const std::string where = "Error: solution " + to_string(s + 1) +
+                                      (function.outputCount > 1 ? ", F" + to_string(o) : std::string()) + ": ";
+            if (!checkCover(function, o, solutionCover(result, s, o), where, error)) return false;
+        }
+    return true;
+}
+
+bool Pla::checkWritten(const PlaFunction& function, const std::string& written, std::string& error) {
+    QM_PROFILE_TIMER("verify");
+    std::istringstream in(written);
+    PlaFunction cover;
+    if (!read(in, cover, error)) {
+        error = "Error: the written PLA doesn't read back: " + error;
+        return false;
+    }
+    if (cover.nbVars != function.nbVars || cover.outputCount != function.outputCount ||
+        cover.inputNames != function.inputNames || cover.outputNames != function.outputNames) {
+        error = "Error: the written PLA has other inputs / outputs than the one read";
+        return false;
+    }
+    for (size_t o = 0; o < function.outputCount; ++o) {
+        const std::string where = "Error: written PLA" + (function.outputCount > 1 ? ", F" + to_string(o) : std::string()) + ": ";
+        if (!checkCover(function, o, cover.onSet(o), where, error)) return false;
+    }
+    return true;
+}
+
+bool Pla::write(std::ostream& out, const PlaFunction& function, const MinimizationResult& result) {
+    // product terms in the order the outputs first use them, each with all of its outputs
+    std::vector<int> order;
+    std::vector<uint64_t> outputs(result.primes.size(), 0);
+    auto use = [&](int idx, size_t o) {
+        if (outputs[(size_t)idx] == 0) order.push_back(idx);
+        outputs[(size_t)idx] |= 1ULL << o;
+    };
+    if (result.outputCount > 1) {
+        if (!result.outputSelections.empty())
+            for (size_t o = 0; o < result.outputSelections[0].size(); ++o)
+                for (int idx : result.outputSelections[0][o]) use(idx, o);
+    } else {
+        for (int idx : result.essential) use(idx, 0);
+        if (!result.solutions.empty())
+            for (int idx : result.solutions[0]) use(idx, 0);
+    }
+
+    PlaWriter writer(out, function.nbVars, function.outputCount, order.size(), function.inputNames, function.outputNames);
+    for (int idx : order) writer.write(result.primes[(size_t)idx].cube, outputs[(size_t)idx]);
+    return writer.finish();
+}
@@ -0,0 +1,120 @@
+//
+// Berkeley PLA (espresso format) input and output, streamed through fixed-size buffers.
+//
+
+#ifndef QM_DD1_PLA_H
+#define QM_DD1_PLA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FileManip.h"
+
+// A PLA as read: its lines are kept as cubes, nothing is expanded to minterms. Each line gives
+// at most two implicants: its on-set outputs ('1') and its don't-care outputs ('-'), the second
+// one flagged isPureDontCare. That list is what generatePrimeImplicants takes.
+struct PlaFunction {
+    int nbVars = 0;
+    size_t outputCount = 1;
+    std::vector<std::string> inputNames;  // .ilb, empty when the file has none
+    std::vector<std::string> outputNames; // .ob
+    std::vector<Implicant> cubes;
+
+    // cubes of output o (a point in both is a don't care, as in espresso)
+    Cover onSet(size_t o) const;
+    Cover dontCares(size_t o) const;
+};
+
+// One pass over a PLA: lines are cut out of 64 KB chunks as they are read, so the memory is one
+// chunk plus the cubes whatever the size of the file. Keywords: .i .o .ilb .ob .p .type .e
+// (the others are rejected); input columns 0 1 - (or 2), output columns 1 (or 4) on, - (or 2)
+// don't care, 0 off, ~ nothing. The columns may be spread out with spaces or '|'.
+class PlaReader {
+public:
+    explicit PlaReader(std::istream& in);
+
+    // the next line of the file into cube and its output masks, with the keywords before it
+    // applied; false at .e / the end of the file, or on an error (then error() is set)
+    bool next(Cube& cube, uint64_t& on, uint64_t& dontCare, uint64_t& off);
+
+    int nbVars() const { return nbVars_; }
+    size_t outputCount() const { return outputCount_; }
+    const std::string& type() const { return type_; } // f, fd (default), fr, fdr, r or dr
+    const std::vector<std::string>& inputNames() const { return inputNames_; }
+    const std::vector<std::string>& outputNames() const { return outputNames_; }
+    const std::string& error() const { return error_; }
+
+private:
+    bool readLine(std::string& line);
+    bool keyword(const std::string& line);
+    bool fail(const std::string& message);
+
+    std::istream& in_;
+    std::vector<char> buffer_;
+    size_t begin_ = 0; // unread bytes are buffer_[begin_, end_)
+    size_t end_ = 0;
+    bool eof_ = false;
+    bool done_ = false;     // .e seen
+    bool sawCube_ = false;  // .i / .o can't change past the first cube
+    size_t lineNumber_ = 0;
+    std::string line_;
+    int nbVars_ = -1;
+    size_t outputCount_ = 1;
+    std::string type_ = "fd";
+    std::vector<std::string> inputNames_;
+    std::vector<std::string> outputNames_;
+    std::string error_;
+};
+
+// Cube lines collect in a 64 KB buffer that goes to the stream whenever it fills up. The header
+// needs the cube count (.p), the lines then follow one write() at a time.
+class PlaWriter {
+public:
+    PlaWriter(std::ostream& out, int nbVars, size_t outputCount, size_t cubeCount,
+              const std::vector<std::string>& inputNames = {}, const std::vector<std::string>& outputNames = {});
+
+    void write(const Cube& cube, uint64_t outputs);
+    // ".e" and the last flush; false when the stream failed
+    bool finish();
+
+private:
+    void flush();
+
+    std::ostream& out_;
+    int nbVars_;
+    size_t outputCount_;
+    std::string buffer_;
+};
+
+class Pla {
+public:
+    // the whole file through a PlaReader; the off-set of an fr / r / dr file is turned into the
+    // missing set (Espresso::complement), per output
+    static bool read(std::istream& in, PlaFunction& function, std::string& error);
+    static bool load(const std::string& filePath, PlaFunction& function, std::string& error);
+
+    // Like FileManip::minimize, from the cubes: the exact engines start generatePrimeImplicants
+    // from them (only the chart's columns are minterms, the on-set points minus the don't
+    // cares), the heuristic runs Espresso on the covers. Engine::Auto picks by the number of
+    // lines, how many of them are next to each other and the on-set's points (see
+    // FileManip::autoPicksExact). The zdd engine takes terms, it runs as exact.
+    // The check (options.verify) works on the cubes too. No result cache.
+    static MinimizationResult minimize(const PlaFunction& function, const RunOptions& options, ThreadPool* pool);
+
+    // every solution covers its outputs' on-set and stays inside on-set + don't cares
+    static bool checkResult(const PlaFunction& function, const MinimizationResult& result, std::string& error);
+
+    // written (what write() made) read back is a PLA with function's inputs / outputs and a
+    // cover of it, like checkResult's
+    static bool checkWritten(const PlaFunction& function, const std::string& written, std::string& error);
+
+    // the first solution of result as a PLA (.type f, one line per product term with the
+    // outputs that use it), with the names of function
+    static bool write(std::ostream& out, const PlaFunction& function, const MinimizationResult& result);
+};
+
+#endif //QM_DD1_PLA_H
@@ -0,0 +1,102 @@
+//
+// Run profile: counters, per-pass series and timers of the hot paths, written as JSON.
+//
+
+#include "Profile.h"
+
+#ifdef QM_PROFILE
+
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <sys/resource.h>
+
+namespace {
+
+struct TimerTotal {
+    uint64_t calls = 0;
+    double totalMs = 0.0;
+};
+
+struct ProfileData {
+    std::mutex lock;
+    std::map<std::string, uint64_t> counters; // maps keep the JSON keys sorted
+    std::map<std::string, std::vector<uint64_t>> series;
+    std::map<std::string, TimerTotal> timers;
+};
+
+ProfileData& data() {
+    static ProfileData profile;
+    return profile;
+}
+
+// ru_maxrss is in kilobytes on Linux and in bytes on macOS
+uint64_t peakRssKB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss / 1024;
+#else
+    return (uint64_t)usage.ru_maxrss;
+#endif
+}
+
+} // namespace
+
+void Profile::add(const char* counter, uint64_t amount) {
+    std::lock_guard<std::mutex> guard(data().lock);
+    data().counters[counter] += amount;
+}
+
+void Profile::append(const char* series, uint64_t value) {
+    std::lock_guard<std::mutex> guard(data().lock);
+    data().series[series].push_back(value);
+}
+
+void Profile::addTime(const char* timer, double ms) {
+    std::lock_guard<std::mutex> guard(data().lock);
+    TimerTotal& total = data().timers[timer];
+    ++total.calls;
+    total.totalMs += ms;
+}
+
+void Profile::reset() {
+    std::lock_guard<std::mutex> guard(data().lock);
+    data().counters.clear();
+    data().series.clear();
+    data().timers.clear();
+}
+
+bool Profile::writeJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    std::lock_guard<std::mutex> guard(data().lock);
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"peakRssKB\": " << peakRssKB() << ",\n  \"counters\": {";
+    bool first = true;
+    for (const auto& counter : data().counters) {
+        out << (first ? "\n" : ",\n") << "    \"" << counter.first << "\": " << counter.second;
+        first = false;
+    }
+    out << "\n  },\n  \"series\": {";
+    first = true;
+    for (const auto& series : data().series) {
+        out << (first ? "\n" : ",\n") << "    \"" << series.first << "\": [";
+        for (size_t i = 0; i < series.second.size(); ++i) out << (i ? ", " : "") << series.second[i];
+        out << "]";
+        first = false;
+    }
+    out << "\n  },\n  \"timers\": {";
+    first = true;
+    for (const auto& timer : data().timers) {
+        out << (first ? "\n" : ",\n") << "    \"" << timer.first << "\": {\"calls\": " << timer.second.calls
+            << ", \"totalMs\": " << timer.second.totalMs << "}";
+        first = false;
+    }
+    out << "\n  }\n}\n";
+    return (bool)out;
+}
+
+#endif
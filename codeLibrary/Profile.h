@@ -0,0 +1,58 @@
+//
+// Run profile: counters, per-pass series and timers of the hot paths, written as JSON.
+//
+
+#ifndef QM_DD1_PROFILE_H
+#define QM_DD1_PROFILE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Everything goes through the QM_PROFILE_* macros below. They are empty unless the build
+// defines QM_PROFILE (-DQM_PROFILE), so a normal build has no counters, no timers and no
+// locks anywhere. Hot loops count into locals declared with QM_PROFILE_ONLY and hand the totals
+// over once per pass / call; the Profile calls themselves take a lock.
+#ifdef QM_PROFILE
+
+class Profile {
+public:
+    static void add(const char* counter, uint64_t amount);  // running total
+    static void append(const char* series, uint64_t value); // one value per pass / call, in order
+    static void addTime(const char* timer, double ms);
+    static void reset();
+    // counters, series, timers (calls and total ms) and the peak resident set size
+    static bool writeJson(const std::string& path);
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char* timer) : name(timer), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            addTime(name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+    private:
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+    };
+};
+
+#define QM_PROFILE_ENABLED 1
+#define QM_PROFILE_ADD(counter, amount) Profile::add(counter, (uint64_t)(amount))
+#define QM_PROFILE_APPEND(series, value) Profile::append(series, (uint64_t)(value))
+#define QM_PROFILE_CONCAT_(a, b) a##b
+#define QM_PROFILE_CONCAT(a, b) QM_PROFILE_CONCAT_(a, b)
+#define QM_PROFILE_TIMER(timer) Profile::ScopedTimer QM_PROFILE_CONCAT(qmProfileTimer, __LINE__)(timer)
+#define QM_PROFILE_ONLY(...) __VA_ARGS__
+
+#else
+
+#define QM_PROFILE_ENABLED 0
+#define QM_PROFILE_ADD(counter, amount) ((void)0)
+#define QM_PROFILE_APPEND(series, value) ((void)0)
+#define QM_PROFILE_TIMER(timer) ((void)0)
+#define QM_PROFILE_ONLY(...)
+
+#endif
+
+#endif //QM_DD1_PROFILE_H
@@ -0,0 +1,212 @@
+//
+// Persistent on-disk cache of minimization results, keyed by a canonical hash of the function.
+//
+
+#include "ResultCache.h"
+
+#include <cstdio>
+#include <thread>
+#include <unistd.h>
+
+#include "MappedFile.h"
+
+namespace {
+
+// bump when the file layout or the minimizer output changes, old files then just miss
+const char kMagic[8] = {'Q', 'M', 'C', 'A', 'C', 'H', 'E', '2'};
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// two lanes with different seeds and multipliers, one word at a time
+struct KeyHasher {
+    uint64_t h1 = 0x243f6a8885a308d3ULL;
+    uint64_t h2 = 0x13198a2e03707344ULL;
+
+    void add(uint64_t word) {
+        h1 = mix64(h1 ^ (word * 0x9e3779b97f4a7c15ULL));
+        h2 = mix64(h2 + word + 0x632be59bd9b4e5d1ULL) * 0xff51afd7ed558ccdULL;
+    }
+    void addTerms(std::vector<Term> terms) {
+        sort(terms.begin(), terms.end());
+        terms.erase(unique(terms.begin(), terms.end()), terms.end());
+        add(terms.size());
+        for (Term t : terms) add(t);
+    }
+};
+
+// everything is stored as little-endian 64-bit words (the hosts we run on are little-endian)
+struct Writer {
+    std::string bytes;
+    void put(uint64_t word) { bytes.append(reinterpret_cast<const char*>(&word), sizeof(word)); }
+    void putInts(const std::vector<int>& values) {
+        put(values.size());
+        for (int v : values) put((uint64_t)v);
+    }
+};
+
+struct Reader {
+    std::string_view bytes;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint64_t get() {
+        if (pos + sizeof(uint64_t) > bytes.size()) {
+            ok = false;
+            return 0;
+        }
+        uint64_t word;
+        std::copy(bytes.data() + pos, bytes.data() + pos + sizeof(word), reinterpret_cast<char*>(&word));
+        pos += sizeof(word);
+        return word;
+    }
+    // a count, checked against what is left in the file so a corrupt one can't allocate gigabytes
+    size_t count() {
+        uint64_t n = get();
+        if (n > (bytes.size() - pos) / sizeof(uint64_t)) {
+            ok = false;
+            return 0;
+        }
+        return (size_t)n;
+    }
+    bool getInts(std::vector<int>& values, size_t limit) {
+        size_t n = count();
+        values.resize(n);
+        for (size_t i = 0; i < n && ok; ++i) {
+            uint64_t v = get();
+            if (v >= limit) ok = false;
+            values[i] = (int)v;
+        }
+        return ok;
+    }
+};
+
+std::string cachePath(const std::string& directory, const CacheKey& key) {
+    return directory + "/" + key.toHex() + ".qmc";
+}
+
+} // namespace
+
+std::string CacheKey::toHex() const {
+    char text[33];
+    snprintf(text, sizeof(text), "%016llx%016llx", (unsigned long long)high, (unsigned long long)low);
+    return text;
+}
+
+CacheKey ResultCache::key(const BooleanFunction& function, bool heuristic, const RunOptions& options) {
+    KeyHasher hasher;
+    hasher.add((uint64_t)function.nbVars);
+    hasher.add(function.outputCount());
+    for (size_t o = 0; o < function.outputCount(); ++o) {
+        hasher.addTerms(function.minterms[o]);
+        hasher.addTerms(function.dontCares[o]);
+    }
+    hasher.add(heuristic ? 1 : 0);
+    hasher.add((uint64_t)options.coverMode);
+    hasher.add(options.reduceChart ? 1 : 0);
+    hasher.add(options.maxSolutions);
+    CacheKey key;
+    key.high = hasher.h1;
+    key.low = hasher.h2;
+    return key;
+}
+
+bool ResultCache::load(const std::string& directory, const CacheKey& key, MinimizationResult& result) {
+    MappedFile file(cachePath(directory, key));
+    if (!file.isOpen()) return false;
+    std::string_view bytes = file.contents();
+    if (bytes.size() < sizeof(kMagic) || bytes.substr(0, sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic)))
+        return false;
+
+    Reader in{bytes, sizeof(kMagic)};
+    if (in.get() != key.high || in.get() != key.low) return false; // a renamed or colliding file
+    MinimizationResult loaded;
+    loaded.heuristic = in.get() != 0;
+    loaded.outputCount = (size_t)in.get();
+    if (loaded.outputCount < 1 || loaded.outputCount > 64) return false;
+
+    const size_t primeCount = in.count();
+    loaded.primes.resize(primeCount);
+    for (Implicant& imp : loaded.primes) {
+        imp.cube.mask = in.get();
+        imp.cube.value = in.get();
+        imp.outputs = in.get();
+        imp.isPureDontCare = in.get() != 0;
+        imp.combined = false;
+    }
+    in.getInts(loaded.essential, primeCount);
+    loaded.remaining.resize(in.count());
+    for (Term& t : loaded.remaining) t = in.get();
+
+    loaded.solutions.resize(in.count());
+    for (ProductTerm& solution : loaded.solutions) {
+        std::vector<int> indices;
+        if (!in.getInts(indices, primeCount)) return false;
+        solution.insert(indices.begin(), indices.end());
+    }
+    loaded.outputSelections.resize(in.count());
+    for (OutputSelection& selection : loaded.outputSelections) {
+        selection.resize(loaded.outputCount);
+        for (std::vector<int>& terms : selection)
+            if (!in.getInts(terms, primeCount)) return false;
+    }
+    if (!in.ok || in.pos != bytes.size()) return false;
+
+    result = std::move(loaded);
+    return true;
+}
+
+bool ResultCache::store(const std::string& directory, const CacheKey& key, const MinimizationResult& result) {
+    Writer out;
+    out.bytes.append(kMagic, sizeof(kMagic));
+    out.put(key.high);
+    out.put(key.low);
+    out.put(result.heuristic ? 1 : 0);
+    out.put(result.outputCount);
+    out.put(result.primes.size());
+    for (const Implicant& imp : result.primes) {
+        out.put(imp.cube.mask);
+        out.put(imp.cube.value);
+        out.put(imp.outputs);
+        out.put(imp.isPureDontCare ? 1 : 0);
+    }
+    out.putInts(result.essential);
+    out.put(result.remaining.size());
+    for (Term t : result.remaining) out.put(t);
+    out.put(result.solutions.size());
+    for (const ProductTerm& solution : result.solutions)
+        out.putInts(std::vector<int>(solution.begin(), solution.end()));
+    out.put(result.outputSelections.size());
+    for (const OutputSelection& selection : result.outputSelections)
+        for (const std::vector<int>& terms : selection) out.putInts(terms);
+
+    // write under a name no other process or thread uses, then rename over the real one
+    const std::string path = cachePath(directory, key);
+    const std::string temporary = path + ".tmp" + std::to_string(getpid()) + "_" +
+                                  std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(out.bytes.data(), (std::streamsize)out.bytes.size());
+        if (!file) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ResultCache::remove(const std::string& directory, const CacheKey& key) {
+    return std::remove(cachePath(directory, key).c_str()) == 0;
+}
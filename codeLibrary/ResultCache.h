@@ -0,0 +1,39 @@
+//
+// Persistent on-disk cache of minimization results, keyed by a canonical hash of the function.
+//
+
+#ifndef QM_DD1_RESULTCACHE_H
+#define QM_DD1_RESULTCACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "FileManip.h"
+
+// 128-bit content key: two independent 64-bit hashes of the canonical function and the options
+// that change the result
+struct CacheKey {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    std::string toHex() const;
+};
+
+// One binary file per key in the cache directory (<key>.qmc): primes (cube, outputs), essentials,
+// remaining minterms, solutions and per-output selections. Files are written to a temporary name
+// and renamed, so concurrent batch workers never see half a file; a file that doesn't read back
+// cleanly (other format version, other key, truncated) is treated as a miss.
+class ResultCache {
+public:
+    // Canonical form: minterms and don't cares of each output sorted and deduplicated, so the
+    // order (and repeats) in the input file don't matter. heuristic is the engine that actually
+    // runs (Auto resolved); the thread count isn't part of the key since it doesn't change results.
+    static CacheKey key(const BooleanFunction& function, bool heuristic, const RunOptions& options);
+
+    static bool load(const std::string& directory, const CacheKey& key, MinimizationResult& result);
+    static bool store(const std::string& directory, const CacheKey& key, const MinimizationResult& result);
+    // drops the entry (a result that failed verification); false if there was none to drop
+    static bool remove(const std::string& directory, const CacheKey& key);
+};
+
+#endif //QM_DD1_RESULTCACHE_H
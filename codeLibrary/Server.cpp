@@ -0,0 +1,424 @@
+//
+// Long-lived front end: minimizes framed requests from a Unix socket or stdin on a thread pool (requests on a second one).
+//
+
+#include "Server.h"
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <mutex>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ThreadPool.h"
+
+namespace {
+
+// a header line longer than this is not a header
+constexpr size_t kMaxHeaderBytes = 4096;
+// biggest function text one request may carry
+constexpr size_t kMaxRequestBytes = (size_t)256 << 20;
+// requests of one connection queued or running at once; past it its reader waits
+constexpr size_t kMaxPendingPerConnection = 256;
+// bytes of results (request key + response text) kept in memory, the oldest ones leave first
+constexpr size_t kMemoryCacheBytes = (size_t)256 << 20;
+// a result bigger than this isn't kept at all (one response can be hundreds of MB)
+constexpr size_t kMemoryCacheEntryBytes = (size_t)16 << 20;
+
+// buffered reads of one descriptor: header lines and payloads of a given size
+class FrameReader {
+public:
+    explicit FrameReader(int fd) : fd(fd) {}
+
+    // false at the end of the stream, or with error set when the line is too long / the read failed
+    bool readLine(std::string& line, std::string& error) {
+        size_t scanned = 0; // bytes after start already searched for the newline
+        while (true) {
+            size_t stop = buffer.find('\n', start + scanned);
+            if (stop != std::string::npos) {
+                line.assign(buffer, start, stop - start);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                start = stop + 1;
+                return true;
+            }
+            scanned = buffer.size() - start;
+            if (scanned > kMaxHeaderBytes) {
+                error = "Error: header longer than " + std::to_string(kMaxHeaderBytes) + " bytes";
+                return false;
+            }
+            if (!fill(error)) return false;
+        }
+    }
+
+    // false when the stream ends first
+    bool readBytes(size_t count, std::string& bytes, std::string& error) {
+        while (buffer.size() - start < count)
+            if (!fill(error)) return false;
+        bytes.assign(buffer, start, count);
+        start += count;
+        return true;
+    }
+
+private:
+    int fd;
+    std::string buffer;
+    size_t start = 0; // first unread byte of buffer
+
+    bool fill(std::string& error) {
+        // drop what was read before growing the buffer (start moves back to 0)
+        if (start > 0) {
+            buffer.erase(0, start);
+            start = 0;
+        }
+        char chunk[65536];
+        while (true) {
+            ssize_t got = read(fd, chunk, sizeof(chunk));
+            if (got > 0) {
+                buffer.append(chunk, (size_t)got);
+                return true;
+            }
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) error = std::string("Error: read failed: ") + strerror(errno);
+            return false;
+        }
+    }
+};
+
+// one client stream. The jobs of its requests hold it, so it stays open until the last answer
+// is written even after the client stopped sending.
+struct Connection {
+    int inFd;
+    int outFd;
+    bool ownsFds; // the socket is closed with the connection, stdin / stdout are not
+
+    std::mutex writeLock; // a frame is written in one piece
+    bool writeFailed = false;
+    std::mutex pendingLock;
+    std::condition_variable pendingChanged;
+    size_t pending = 0;
+
+    Connection(int in, int out, bool owns) : inFd(in), outFd(out), ownsFds(owns) {}
+    ~Connection() {
+        if (ownsFds) close(inFd);
+    }
+
+    void send(const std::string& frame) {
+        std::lock_guard<std::mutex> guard(writeLock);
+        size_t written = 0;
+        while (!writeFailed && written < frame.size()) {
+            ssize_t n = write(outFd, frame.data() + written, frame.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) writeFailed = true; // the client went away, the other answers are dropped
+            else written += (size_t)n;
+        }
+    }
+};
+
+// results by request (options + function text), shared by every connection, held to
+// kMemoryCacheBytes in total
+class MemoryCache {
+public:
+    struct Entry {
+        bool heuristic = false;
+        std::string text;
+    };
+
+    bool find(const std::string& key, Entry& entry) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = entries.find(key);
+        if (it == entries.end()) return false;
+        entry = it->second;
+        return true;
+    }
+
+    void store(const std::string& key, const Entry& entry) {
+        const size_t size = bytes(key, entry);
+        if (size > kMemoryCacheEntryBytes) return;
+        std::lock_guard<std::mutex> guard(lock);
+        if (!entries.emplace(key, entry).second) return;
+        order.push_back(key);
+        used += size;
+        while (used > kMemoryCacheBytes) {
+            auto oldest = entries.find(order.front());
+            used -= bytes(oldest->first, oldest->second);
+            entries.erase(oldest);
+            order.pop_front();
+        }
+    }
+
+private:
+    static size_t bytes(const std::string& key, const Entry& entry) {
+        // the key is held twice (map and order)
+        return 2 * key.size() + entry.text.size();
+    }
+
+    std::mutex lock;
+    size_t used = 0; // bytes() of every entry
+    std::unordered_map<std::string, Entry> entries;
+    std::deque<std::string> order; // oldest first
+};
+
+std::string frame(const std::string& id, const std::string& status, const std::string& fields, const std::string& payload) {
+    std::string header = id + " " + status + " " + std::to_string(payload.size());
+    if (!fields.empty()) header += " " + fields;
+    return header + "\n" + payload;
+}
+
+std::string errorFrame(const std::string& id, const std::string& message) {
+    return frame(id, "error", "", message + "\n");
+}
+
+// one key=value of a request header
+bool applyOption(const std::string& token, RunOptions& options, std::string& error) {
+    const size_t eq = token.find('=');
+    const std::string key = token.substr(0, eq);
+    const std::string value = (eq == std::string::npos) ? "" : token.substr(eq + 1);
+    auto unknown = [&] {
+        error = "Error: unknown request option " + token;
+        return false;
+    };
+    if (key == "engine") {
+        if (value == "auto") options.engine = Engine::Auto;
+        else if (value == "exact") options.engine = Engine::Exact;
+        else if (value == "heuristic") options.engine = Engine::Heuristic;
+        else if (value == "zdd") options.engine = Engine::Zdd;
+        else return unknown();
+        return true;
+    }
+    if (key == "cover") {
+        if (value == "bnb") options.coverMode = CoverMode::BranchAndBound;
+        else if (value == "petrick") options.coverMode = CoverMode::Petrick;
+        else if (value == "ptree") options.coverMode = CoverMode::PetrickTree;
+        else return unknown();
+        return true;
+    }
+    if ((key == "reduce" || key == "verify") && (value == "0" || value == "1")) {
+        (key == "reduce" ? options.reduceChart : options.verify) = value == "1";
+        return true;
+    }
+    return unknown();
+}
+
+// the options a result depends on, as the start of its memory cache key
+std::string optionKey(const RunOptions& options) {
+    return std::to_string((int)options.engine) + " " + std::to_string((int)options.coverMode) + " " +
+           std::to_string(options.petrickMemoryMB) + " " + std::to_string(options.maxSolutions) + " " +
+           (options.reduceChart ? "r" : "-") +
+           (options.verify ? "v" : "-") + "\n";
+}
+
+// minimizes one request and returns its response frame (runs on the request executor, pool is
+// for the stages inside)
+std::string answer(const std::string& id, const RunOptions& options, const std::string& text, ThreadPool& pool,
+                   MemoryCache& cache) {
+    const auto start = std::chrono::steady_clock::now();
+    auto fields = [&](bool heuristic, bool cached) {
+        std::ostringstream out;
+        out << "engine=" << (heuristic ? "heuristic" : "exact") << " cached=" << (cached ? 1 : 0) << " ms="
+            << std::fixed << std::setprecision(3)
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return out.str();
+    };
+
+    const std::string key = optionKey(options) + text;
+    MemoryCache::Entry entry;
+    if (cache.find(key, entry)) return frame(id, "ok", fields(entry.heuristic, true), entry.text);
+
+    // a function too big for the memory (or anything else that throws) fails its own request,
+    // the server keeps going
+    try {
+        BooleanFunction function;
+        std::string error;
+        if (!FileManip::parseFunction(text, function, error)) return errorFrame(id, error);
+        MinimizationResult result = FileManip::minimize(function, options, &pool, false);
+        if (!result.verifyError.empty()) return errorFrame(id, result.verifyError);
+        entry.heuristic = result.heuristic;
+        entry.text = FileManip::resultText(result, function.nbVars);
+        cache.store(key, entry);
+        return frame(id, "ok", fields(result.heuristic, result.fromCache), entry.text);
+    } catch (const std::bad_alloc&) {
+        return errorFrame(id, "Error: out of memory");
+    } catch (const std::exception& e) {
+        return errorFrame(id, std::string("Error: ") + e.what());
+    }
+}
+
+// reads the frames of one connection and queues them on `requests`, until the stream ends or a
+// header can't be read; returns once every answer of the connection is written
+void serveConnection(const std::shared_ptr<Connection>& connection, const RunOptions& defaults, ThreadPool& requests,
+                     ThreadPool& pool, MemoryCache& cache) {
+    FrameReader reader(connection->inFd);
+    std::string header, error;
+    while (reader.readLine(header, error)) {
+        if (header.find_first_not_of(" \t") == std::string::npos) continue; // blank lines between frames
+        std::istringstream words(header);
+        std::string id, size;
+        words >> id >> size;
+        size_t bytes = 0;
+        auto parsed = std::from_chars(size.data(), size.data() + size.size(), bytes);
+        if (size.empty() || parsed.ec != std::errc() || parsed.ptr != size.data() + size.size()) {
+            error = "Error: expected \"<id> <bytes> [options]\", got: " + header;
+            break;
+        }
+        if (bytes > kMaxRequestBytes) {
+            error = "Error: request " + id + " is bigger than " + std::to_string(kMaxRequestBytes) + " bytes";
+            break;
+        }
+        std::string text;
+        if (!reader.readBytes(bytes, text, error)) {
+            if (error.empty()) error = "Error: the stream ended inside request " + id;
+            break;
+        }
+
+        // a bad option only fails this request, its payload is already read
+        RunOptions options = defaults;
+        std::string token, optionError;
+        bool coverGiven = false;
+        while (words >> token && optionError.empty()) {
+            applyOption(token, options, optionError);
+            coverGiven = coverGiven || token.compare(0, 6, "cover=") == 0;
+        }
+        if (!optionError.empty()) {
+            connection->send(errorFrame(id, optionError));
+            continue;
+        }
+        // as on the command line, a cover solver means the exact engine unless one is named
+        if (coverGiven && options.engine == Engine::Auto) options.engine = Engine::Exact;
+
+        {
+            std::unique_lock<std::mutex> guard(connection->pendingLock);
+            connection->pendingChanged.wait(guard, [&] { return connection->pending < kMaxPendingPerConnection; });
+            ++connection->pending;
+        }
+        requests.submit([connection, id, options, text = std::move(text), &pool, &cache] {
+            connection->send(answer(id, options, text, pool, cache));
+            std::lock_guard<std::mutex> guard(connection->pendingLock);
+            --connection->pending;
+            connection->pendingChanged.notify_all();
+        });
+    }
+    if (!error.empty()) connection->send(errorFrame("-", error));
+
+    std::unique_lock<std::mutex> guard(connection->pendingLock);
+    connection->pendingChanged.wait(guard, [&] { return connection->pending == 0; });
+}
+
+int listenOn(const std::string& path, std::string& error) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = "Error: socket path too long: " + path;
+        return -1;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // a socket file left by a server that was killed is replaced, anything else is kept: a
+    // socket someone still accepts on belongs to a live server, so only a refused connect frees it
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            error = "Error: " + path + " exists and is not a socket";
+            return -1;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe < 0) {
+            error = std::string("Error: socket: ") + strerror(errno);
+            return -1;
+        }
+        const int connected = connect(probe, (const sockaddr*)&address, sizeof(address));
+        const int connectError = errno;
+        close(probe);
+        if (connected == 0) {
+            error = "Error: " + path + " is already in use by another server";
+            return -1;
+        }
+        if (connectError != ECONNREFUSED) {
+            error = "Error: could not check " + path + ": " + strerror(connectError);
+            return -1;
+        }
+        unlink(path.c_str());
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::string("Error: socket: ") + strerror(errno);
+        return -1;
+    }
+    if (bind(fd, (const sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        error = "Error: could not listen on " + path + ": " + strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+int Server::run(const std::string& socketPath, const RunOptions& options) {
+    // a client that disconnects early must not kill the server on the next write
+    signal(SIGPIPE, SIG_IGN);
+    // whole requests run on their own executor, the stages inside them on pool: a request that
+    // waits in pool.run() helps with prime generation chunks, and never with somebody else's
+    // request (which could nest without bound on its stack)
+    ThreadPool pool(options.threads);
+    ThreadPool requests(pool.size());
+    MemoryCache cache;
+
+    if (socketPath == "-") {
+        serveConnection(std::make_shared<Connection>(STDIN_FILENO, STDOUT_FILENO, false), options, requests, pool, cache);
+        return 0;
+    }
+
+    std::string error;
+    int listener = listenOn(socketPath, error);
+    if (listener < 0) {
+        cerr << error << endl;
+        return 1;
+    }
+    cerr << "Serving on " << socketPath << " with " << pool.size() << " thread(s)\n";
+
+    // every connection has its own reader thread; the pools and the cache outlive them all
+    std::mutex activeLock;
+    std::condition_variable activeChanged;
+    size_t active = 0;
+    int status = 0;
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            cerr << "Error: accept failed: " << strerror(errno) << endl;
+            status = 1;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> guard(activeLock);
+            ++active;
+        }
+        std::thread([&, client] {
+            serveConnection(std::make_shared<Connection>(client, client, true), options, requests, pool, cache);
+            std::lock_guard<std::mutex> guard(activeLock);
+            --active;
+            activeChanged.notify_all();
+        }).detach();
+    }
+    close(listener);
+    unlink(socketPath.c_str());
+    std::unique_lock<std::mutex> guard(activeLock);
+    activeChanged.wait(guard, [&] { return active == 0; });
+    return status;
+}
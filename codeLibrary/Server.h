@@ -0,0 +1,33 @@
+//
+// Long-lived front end: minimizes framed requests from a Unix socket or stdin on a thread pool (requests on a second one).
+//
+
+#ifndef QM_DD1_SERVER_H
+#define QM_DD1_SERVER_H
+
+#include <string>
+
+#include "FileManip.h"
+
+// Protocol (text, one frame after another on the same stream):
+//   request:  <id> <bytes>[ engine=auto|exact|heuristic|zdd][ cover=bnb|petrick|ptree][ reduce=0|1][ verify=0|1]\n
+//             followed by <bytes> bytes of a function file (variable count, minterm and don't care
+//             lines per output, ranges allowed)
+//   response: <id> ok <bytes> engine=exact|heuristic cached=0|1 ms=<minimize time>\n<bytes> bytes of
+//             solutions as --batch writes them ("Solution 1: F = ...")
+//             <id> error <bytes>\n<bytes> bytes of message
+// The id is any word the client picks; options it leaves out come from the command line (cover=
+// under engine auto picks exact, as --cover does). Requests are minimized concurrently and
+// answered as they finish, so responses come back out of order.
+// A header that can't be read ends the connection (the stream can't be resynchronized), a bad
+// function only fails its own request. Results are also kept in memory (up to 256 MB, none over
+// 16 MB), so a request repeated on any connection is answered without minimizing again (the
+// --cache directory works as usual).
+class Server {
+public:
+    // socketPath "-" serves stdin / stdout until stdin ends; otherwise listens on a Unix socket
+    // at that path (a stale socket file is replaced), one connection per client. Returns the exit status.
+    static int run(const std::string& socketPath, const RunOptions& options);
+};
+
+#endif //QM_DD1_SERVER_H
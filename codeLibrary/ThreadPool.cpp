@@ -0,0 +1,151 @@
+//
+// Small work-stealing thread pool shared by the parallel stages.
+//
+
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <exception>
+
+namespace {
+// pool and worker index of the current thread (currentPool is null outside any pool)
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+}
+
+int ThreadPool::hardwareThreads() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : (int)hw;
+}
+
+ThreadPool::ThreadPool(int threads) {
+    threadCount = (threads <= 0) ? hardwareThreads() : threads;
+    if (threadCount == 1) return; // everything runs inline
+
+    for (int i = 0; i < threadCount; ++i)
+        queues.push_back(std::make_unique<WorkerQueue>());
+    for (int i = 0; i < threadCount; ++i)
+        workers.emplace_back([this, i] { workerLoop((size_t)i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    if (workers.empty()) {
+        job();
+        return;
+    }
+    // own deque when called from one of our workers, otherwise round-robin
+    size_t target = (currentPool == this) ? currentWorker
+                                          : nextQueue.fetch_add(1) % queues.size();
+    {
+        // count the job before it becomes visible so the counter never drops below zero;
+        // taking the sleep lock orders the increment with a worker about to wait
+        std::lock_guard<std::mutex> guard(sleepLock);
+        queued.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        if (currentPool == this) queues[target]->jobs.push_front(std::move(job));
+        else queues[target]->jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::popOrSteal(size_t self, std::function<void()>& job) {
+    // own work first, from the front
+    {
+        WorkerQueue& own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.front());
+            own.jobs.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    // then steal from the back of the others
+    for (size_t k = 1; k < queues.size(); ++k) {
+        WorkerQueue& victim = *queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.back());
+            victim.jobs.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    currentPool = this;
+    currentWorker = self;
+    std::function<void()> job;
+    while (true) {
+        if (popOrSteal(self, job)) {
+            job();
+            job = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    struct Batch {
+        std::atomic<size_t> remaining;
+        std::mutex lock;
+        std::condition_variable done;
+        std::exception_ptr failure; // the first task that threw (under lock)
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = count;
+
+    for (size_t i = 0; i < count; ++i) {
+        submit([batch, &task, i] {
+            // a throwing task (bad_alloc on a huge input) must not end the worker thread: the
+            // exception goes back to the caller of run(), once every task has finished
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(batch->lock);
+                if (!batch->failure) batch->failure = std::current_exception();
+            }
+            if (batch->remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> guard(batch->lock);
+                batch->done.notify_all();
+            }
+        });
+    }
+
+    // help out instead of blocking; a worker calling run() must not sit idle on its own queue
+    size_t self = (currentPool == this) ? currentWorker : 0;
+    std::function<void()> job;
+    while (batch->remaining.load() > 0) {
+        if (popOrSteal(self, job)) {
+            job();
+            job = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(batch->lock);
+        batch->done.wait_for(guard, std::chrono::milliseconds(1),
+                             [&] { return batch->remaining.load() == 0; });
+    }
+    std::lock_guard<std::mutex> guard(batch->lock);
+    if (batch->failure) std::rethrow_exception(batch->failure);
+}
@@ -0,0 +1,62 @@
+//
+// Small work-stealing thread pool shared by the parallel stages.
+//
+
+#ifndef QM_DD1_THREADPOOL_H
+#define QM_DD1_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Every worker owns a deque. Work submitted from a worker goes to the front of its own deque
+// (so it keeps its cache), work submitted from outside is dealt round-robin, and a worker whose
+// deque is empty steals from the back of the others before going to sleep.
+class ThreadPool {
+public:
+    // threads <= 0 picks the hardware thread count; 1 means "run everything inline"
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return threadCount; }
+
+    // queue a job; it runs on some worker (or inline when the pool has no workers)
+    void submit(std::function<void()> job);
+
+    // run task(0..count-1) and return when all of them are done. The calling thread helps
+    // with the queued work, so this is safe to call from inside another pool task. If a task
+    // throws, the first exception is rethrown here after the others are done.
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+    static int hardwareThreads();
+
+private:
+    struct WorkerQueue {
+        std::mutex lock;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    bool popOrSteal(size_t self, std::function<void()>& job);
+    void workerLoop(size_t self);
+
+    int threadCount;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> nextQueue{0};
+    bool stopping = false;
+};
+
+#endif //QM_DD1_THREADPOOL_H
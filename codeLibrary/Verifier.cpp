@@ -0,0 +1,219 @@
+//
+// Bit-sliced / cube-containment check of minimized covers (see Verifier.h).
+//
+
+#include "Verifier.h"
+
+#include <unordered_map>
+
+#include "Profile.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QM_VERIFIER_X86 1
+#endif
+
+namespace {
+
+// past this the bitmaps get big (3 x 2^22 bits = 1.5 MB), sparser functions use containment
+constexpr int kMaxSlicedVars = 22;
+// bitmaps while there is at least one term per this many points
+constexpr uint64_t kSlicedPointsPerTerm = 4096;
+
+// variable i (i < 6) over the 64 points of a word: bit p is bit i of p
+constexpr uint64_t kLowVarWords[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL};
+
+// first word with a minterm outside the cover or a cover point outside on + dc (words if none)
+size_t firstBadWordScalar(const uint64_t* need, const uint64_t* allowed, const uint64_t* covered, size_t words) {
+    for (size_t w = 0; w < words; ++w)
+        if ((need[w] & ~covered[w]) | (covered[w] & ~allowed[w])) return w;
+    return words;
+}
+
+#ifdef QM_VERIFIER_X86
+__attribute__((target("avx2")))
+size_t firstBadWordAvx2(const uint64_t* need, const uint64_t* allowed, const uint64_t* covered, size_t words) {
+    size_t w = 0;
+    for (; w + 4 <= words; w += 4) {
+        const __m256i n = _mm256_loadu_si256((const __m256i*)(need + w));
+        const __m256i a = _mm256_loadu_si256((const __m256i*)(allowed + w));
+        const __m256i c = _mm256_loadu_si256((const __m256i*)(covered + w));
+        const __m256i bad = _mm256_or_si256(_mm256_andnot_si256(c, n), _mm256_andnot_si256(a, c));
+        if (!_mm256_testz_si256(bad, bad)) break;
+    }
+    return w + firstBadWordScalar(need + w, allowed + w, covered + w, words - w);
+}
+#endif
+
+size_t firstBadWord(const uint64_t* need, const uint64_t* allowed, const uint64_t* covered, size_t words) {
+#ifdef QM_VERIFIER_X86
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) return firstBadWordAvx2(need, allowed, covered, words);
+#endif
+    return firstBadWordScalar(need, allowed, covered, words);
+}
+
+// one output's on-set and don't cares, kept in the form the check needs so the solutions of a
+// result are all checked against the same one
+class OutputCheck {
+public:
+    OutputCheck(int nbVars, const vector<Term>& minterms, const vector<Term>& dontCares)
+        : n(nbVars), sliced(Verifier::usesSlices(nbVars, minterms.size() + dontCares.size())) {
+        if (sliced) {
+            const size_t words = (n > 6) ? (size_t)1 << (n - 6) : 1;
+            need.assign(words, 0);
+            allowed.assign(words, 0);
+            covered.assign(words, 0);
+            for (Term m : minterms) need[m >> 6] |= 1ULL << (m & 63);
+            allowed = need;
+            for (Term d : dontCares) allowed[d >> 6] |= 1ULL << (d & 63);
+        } else {
+            // a term listed as both stays a minterm
+            points.reserve(minterms.size() + dontCares.size());
+            for (Term d : dontCares) points.emplace(d, 0);
+            for (Term m : minterms) points[m] = 1;
+            for (const auto& p : points) mintermCount += p.second;
+        }
+    }
+
+    bool check(const vector<Cube>& cover, string& error) {
+        return sliced ? checkSliced(cover, error) : checkContainment(cover, error);
+    }
+
+private:
+    int n;
+    bool sliced;
+    vector<uint64_t> need, allowed, covered; // sliced: bit t of the space is point t
+    unordered_map<Term, char> points;        // containment: on + dc, 1 for a minterm
+    size_t mintermCount = 0;
+
+    string offSetError(const vector<Cube>& cover, Term point) const {
+        for (const Cube& c : cover)
+            if (c.contains(point))
+                return "cube " + c.toPattern(n) + " covers " + to_string(point) + ", which is in the off-set";
+        return to_string(point) + " is covered but is in the off-set";
+    }
+
+    bool checkSliced(const vector<Cube>& cover, string& error) {
+        const int lowVars = std::min(n, 6);
+        const uint64_t validBits = (n >= 6) ? ~0ULL : ((1ULL << (1u << n)) - 1ULL);
+        const uint64_t highFree = (n > 6) ? (Cube::fullMask(n - 6)) : 0;
+        std::fill(covered.begin(), covered.end(), 0);
+        for (const Cube& c : cover) {
+            // the cube inside one word, then every word its high variables allow
+            uint64_t low = validBits;
+            for (int i = 0; i < lowVars; ++i)
+                if (c.mask >> i & 1) low &= (c.value >> i & 1) ? kLowVarWords[i] : ~kLowVarWords[i];
+            const uint64_t base = c.value >> 6;
+            const uint64_t free = highFree & ~(c.mask >> 6);
+            uint64_t s = 0;
+            do {
+                covered[base | s] |= low;
+                s = (s - free) & free;
+            } while (s != 0);
+        }
+        const size_t w = firstBadWord(need.data(), allowed.data(), covered.data(), covered.size());
+        if (w == covered.size()) return true;
+        const uint64_t missing = need[w] & ~covered[w];
+        const uint64_t extra = covered[w] & ~allowed[w];
+        if (missing) {
+            error = "minterm " + to_string(((Term)w << 6) | (Term)__builtin_ctzll(missing)) + " is not covered";
+        } else {
+            error = offSetError(cover, ((Term)w << 6) | (Term)__builtin_ctzll(extra));
+        }
+        return false;
+    }
+
+    bool checkContainment(const vector<Cube>& cover, string& error) {
+        // every point of every cube has to be in on + dc; a cube with more points than that
+        // stops at the first one that isn't, so no cube costs more than |on + dc| lookups.
+        // A minterm some cube has is marked 3 until the end of the check.
+        const uint64_t space = Cube::fullMask(n);
+        size_t hit = 0;
+        bool ok = true;
+        for (const Cube& c : cover) {
+            const uint64_t free = space & ~c.mask;
+            uint64_t s = 0;
+            do {
+                const Term point = c.value | s;
+                auto it = points.find(point);
+                if (it == points.end()) {
+                    error = offSetError(cover, point);
+                    ok = false;
+                    break;
+                }
+                if (it->second == 1) {
+                    it->second = 3;
+                    ++hit;
+                }
+                s = (s - free) & free;
+            } while (s != 0);
+            if (!ok) break;
+        }
+        if (ok && hit != mintermCount) {
+            for (const auto& p : points) {
+                if (p.second == 1) {
+                    error = "minterm " + to_string(p.first) + " is not covered";
+                    break;
+                }
+            }
+            ok = false;
+        }
+        if (hit)
+            for (auto& p : points) p.second &= 1;
+        return ok;
+    }
+};
+
+} // namespace
+
+bool Verifier::usesSlices(int nbVars, size_t terms) {
+    if (nbVars > kMaxSlicedVars) return false;
+    return (1ULL << nbVars) <= kSlicedPointsPerTerm * ((uint64_t)terms + 1);
+}
+
+bool Verifier::checkCover(int nbVars, const vector<Cube>& cover, const vector<Term>& minterms,
+                          const vector<Term>& dontCares, string& error) {
+    OutputCheck check(nbVars, minterms, dontCares);
+    if (check.check(cover, error)) return true;
+    error = "Error: " + error;
+    return false;
+}
+
+bool Verifier::checkResult(const BooleanFunction& function, const MinimizationResult& result, string& error) {
+    QM_PROFILE_TIMER("verify");
+    const int n = function.nbVars;
+    vector<Cube> cover;
+    if (function.outputCount() > 1) {
+        for (size_t o = 0; o < function.outputCount(); ++o) {
+            OutputCheck check(n, function.minterms[o], function.dontCares[o]);
+            for (size_t s = 0; s < result.outputSelections.size(); ++s) {
+                cover.clear();
+                if (o < result.outputSelections[s].size())
+                    for (int idx : result.outputSelections[s][o]) cover.push_back(result.primes[(size_t)idx].cube);
+                if (!check.check(cover, error)) {
+                    error = "Error: solution " + to_string(s + 1) + ", F" + to_string(o) + ": " + error;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // as solutionStrings lists them: with no solution the EPIs alone are the one cover
+    OutputCheck check(n, function.minterms[0], function.dontCares[0]);
+    const size_t solutionCount = std::max<size_t>(result.solutions.size(), 1);
+    for (size_t s = 0; s < solutionCount; ++s) {
+        cover.clear();
+        for (int idx : result.essential) cover.push_back(result.primes[(size_t)idx].cube);
+        if (s < result.solutions.size())
+            for (int idx : result.solutions[s]) cover.push_back(result.primes[(size_t)idx].cube);
+        if (!check.check(cover, error)) {
+            error = "Error: solution " + to_string(s + 1) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+//
+// Built-in check that a minimized SOP is the function it was made from.
+//
+
+#ifndef QM_DD1_VERIFIER_H
+#define QM_DD1_VERIFIER_H
+
+#include <string>
+#include <vector>
+
+#include "FileManip.h"
+
+// A cover is right when it is 1 on every minterm and 0 on every point that is neither a
+// minterm nor a don't care. Two ways to check it, picked by the size of the space:
+//  - bit-sliced: the on-set, on + dc and the cover's points are bitmaps of the whole space,
+//    64 points per word (the low 6 variables are constant words, a cube only writes the words
+//    of its high variables), compared 4 words at a time with AVX2 when the CPU has it,
+//  - cube containment, for sparse functions with many variables: each cube's points are looked
+//    up in on + dc (a cube with more points than that can't fit), which also marks the minterms.
+// Either way the cost is about the size of the function, not of the cover's expression.
+class Verifier {
+public:
+    // false with the first wrong point in error
+    static bool checkCover(int nbVars, const std::vector<Cube>& cover, const std::vector<Term>& minterms,
+                           const std::vector<Term>& dontCares, std::string& error);
+    // every solution (every output of every solution) of a minimization of function
+    static bool checkResult(const BooleanFunction& function, const MinimizationResult& result, std::string& error);
+
+    // true when a function of this size is checked on bitmaps
+    static bool usesSlices(int nbVars, size_t terms);
+};
+
+#endif //QM_DD1_VERIFIER_H
@@ -8,117 +8,46 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <cctype>
 
 using namespace std; // for the endl at the end
 
+// variable names: A, B, C... while they fit in the alphabet, x0, x1, x2... beyond 26 variables
+std::string VerilogConverter::variableName(int index, int numVariables) {
+    if (numVariables <= 26) return std::string(1, (char)('A' + index));
+    return "x" + std::to_string(index);
+}
+
 // helper function to convert normal boolean into verilog syntax
+// A' --> ~A, + --> |, and an & between literals written next to each other (AB'C --> A&~B&C).
+// A variable is a letter followed by any digits, so x12x3' works the same way as AB'.
 std::string VerilogConverter::convertToVerilogSyntax(const std::string& booleanFunction) {
-    std::string verilog = booleanFunction;
-
-    // 1. NOT operator A' --> ~A
-    size_t pos = 0;
-    while ((pos = verilog.find("'", pos)) != std::string::npos) {
-        // variable right before the '
-        if (pos > 0) {
-            char var = verilog[pos - 1];
-            // Replace the variable and the ' with the Verilog NOT syntax
-            verilog.replace(pos - 1, 2, "~" + std::string(1, var));
-        }
-    }
-
-    // OR operator + --> |
-
-    std::replace(verilog.begin(), verilog.end(), '+', '|');
-
-    // 3. AND operator A B-> A & B
-    // This is the most complex step: Verilog requires explicit '&' between terms.
-    std::string result = "";
-    for (size_t i = 0; i < verilog.length(); ++i) {
-        char current = verilog[i];
-        result += current;
-
-        if (i + 1 < verilog.length()) {
-            char next = verilog[i + 1];
-
-            // the criteria we are checking for are:
-            // 1. current carr is variable or )
-            // 2. next char is a variable (
-            // 3. no verliog operator between the two characters
-
-
-            bool currentIsVarOrNot = (std::isalpha(current) || current == ')');
-            bool nextIsVarOrNot = (std::isalpha(next) || next == '(' || next == '~');
-
-            if (currentIsVarOrNot && nextIsVarOrNot) {
-                result += " & ";
-            } else if (currentIsVarOrNot && next == '~') { // case A~B
-                 result += " & ";
-            } else if (current == '~' && std::isalpha(next) && (i + 2 < verilog.length() && verilog[i+2] != '|')) {
-                 // case ~AB
-                 if (std::isalpha(verilog[i+2])) {
-                    result += " & ";
-                 }
+    std::string verilog = "";
+    bool afterLiteral = false; // the last thing written was a literal, so the next one needs an &
+    size_t i = 0;
+    while (i < booleanFunction.length()) {
+        char current = booleanFunction[i];
+        if (std::isalpha((unsigned char)current)) {
+            size_t end = i + 1;
+            while (end < booleanFunction.length() && std::isdigit((unsigned char)booleanFunction[end])) end++;
+            std::string name = booleanFunction.substr(i, end - i);
+            if (afterLiteral) verilog += "&";
+            if (end < booleanFunction.length() && booleanFunction[end] == '\'') {
+                verilog += "~" + name;
+                end++;
+            } else {
+                verilog += name;
             }
+            afterLiteral = true;
+            i = end;
+            continue;
         }
+        // OR operator + --> |, anything else (spaces, the constant 1) is copied
+        verilog += (current == '+') ? '|' : current;
+        afterLiteral = false;
+        i++;
     }
-
-    // cleaning up and removing spaces
-    std::string cleaned_result = "";
-    for (char c : result) {
-        if (c != ' ' && c != '\t') {
-            cleaned_result += c;
-        }
-    }
-
-    std::string final_verilog = "";
-    for (size_t i = 0; i < cleaned_result.length(); ++i) {
-        char current = cleaned_result[i];
-        final_verilog += current;
-
-        if (std::isalpha(current) && i + 1 < cleaned_result.length() && std::isalpha(cleaned_result[i+1])) {
-             final_verilog += "&";
-        }
-    }
-
-    //replacingggg
-
-    std::string minimal_verilog = booleanFunction;
-
-    // Replace ' with ~
-    for (size_t i = 0; i < minimal_verilog.length(); ++i) {
-        if (minimal_verilog[i] == '\'') {
-            if (i > 0) {
-                minimal_verilog.replace(i - 1, 2, "~" + std::string(1, minimal_verilog[i-1]));
-                i--; // Adjust index due to length change
-            }
-        }
-    }
-
-
-    std::replace(minimal_verilog.begin(), minimal_verilog.end(), '+', '|');
-
-
-    std::string and_inserted = "";
-    for (size_t i = 0; i < minimal_verilog.length(); ++i) {
-        char current = minimal_verilog[i];
-        and_inserted += current;
-
-        if (i + 1 < minimal_verilog.length()) {
-            char next = minimal_verilog[i + 1];
-
-            // checking for adjacent variables
-            bool is_variable_char = std::isalpha(current) || current == '~';
-            bool next_is_variable_char = std::isalpha(next) || next == '~';
-
-            // adding & if adjacent and not spereated by |
-            if (is_variable_char && next_is_variable_char && current != '~' && next != '|') {
-                 and_inserted += "&";
-            }
-        }
-    }
-
-
-    return and_inserted;
+    return verilog;
 }
 
 // Function that generates the final Verilog module
@@ -139,10 +68,10 @@ bool VerilogConverter::generateVerilogModule(
         return false;
     }
 
-    // Determine input variables (A, B, C, D...)
+    // Determine input variables (A, B, C, D... or x0, x1, x2...)
     std::string inputs = "";
     for (int i = 0; i < numVariables; ++i) {
-        inputs += (char)('A' + i);
+        inputs += variableName(i, numVariables);
         if (i < numVariables - 1) {
             inputs += ", ";
         }
@@ -175,4 +104,88 @@ bool VerilogConverter::generateVerilogModule(
               << "' has been successfully generated and and saved to " << outputFileName << endl;
 
     return true;
-}
\ No newline at end of file
+}
+// Multi-output module: the SOP strings are split at " + ", every distinct product term gets a
+// wire tK, and each output ORs its wires
+bool VerilogConverter::generateMultiOutputModule(
+    const std::string& functionName,
+    const std::vector<std::string>& outputFunctions,
+    int numVariables,
+    const std::string& outputFileName
+) {
+    if (outputFunctions.empty()) {
+        std::cerr << "Error: no output functions.\n";
+        return false;
+    }
+    std::string desiredOutputPath = "../verilogGenerationSamples/"+outputFileName;
+    std::ofstream outFile(desiredOutputPath);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Could not open file " << outputFileName << " for writing.\n";
+        return false;
+    }
+
+    std::string inputs = "";
+    for (int i = 0; i < numVariables; ++i) {
+        inputs += variableName(i, numVariables);
+        if (i < numVariables - 1) {
+            inputs += ", ";
+        }
+    }
+
+    // product term -> wire number, in order of first use
+    std::vector<std::string> products;
+    std::vector<std::vector<int>> outputWires(outputFunctions.size());
+    for (size_t o = 0; o < outputFunctions.size(); ++o) {
+        const std::string& function = outputFunctions[o];
+        if (function == "0" || function == "1") continue; // constants, no wire
+        size_t start = 0;
+        while (start <= function.size()) {
+            size_t stop = function.find(" + ", start);
+            if (stop == std::string::npos) stop = function.size();
+            std::string product = function.substr(start, stop - start);
+            size_t wire = std::find(products.begin(), products.end(), product) - products.begin();
+            if (wire == products.size()) products.push_back(product);
+            outputWires[o].push_back((int)wire);
+            start = stop + 3;
+        }
+    }
+
+    outFile << "`timescale 1ns / 1ps" << endl;
+    outFile << "//////////////////////////////////////////////////////////////////////////////////" << endl;
+    outFile << "// Module: " << functionName << endl;
+    for (size_t o = 0; o < outputFunctions.size(); ++o)
+        outFile << "// Minimized Function F" << o << " (SOP): " << outputFunctions[o] << endl;
+    outFile << "//////////////////////////////////////////////////////////////////////////////////"<<endl;
+
+    outFile << "module " << functionName << "(" << endl;
+    for (size_t o = 0; o < outputFunctions.size(); ++o)
+        outFile << "    output wire F" << o << ","<<endl;
+    outFile << "    input wire " << inputs << endl;
+    outFile << ");" << endl << endl;
+
+    // shared AND terms
+    for (size_t k = 0; k < products.size(); ++k)
+        outFile << "wire t" << k << " = " << convertToVerilogSyntax(products[k]) << ";\n";
+    if (!products.empty()) outFile << "\n";
+
+    for (size_t o = 0; o < outputFunctions.size(); ++o) {
+        outFile << "assign F" << o << " = ";
+        if (outputFunctions[o] == "0") outFile << "1'b0";
+        else if (outputFunctions[o] == "1") outFile << "1'b1";
+        else {
+            for (size_t k = 0; k < outputWires[o].size(); ++k) {
+                if (k > 0) outFile << " | ";
+                outFile << "t" << outputWires[o][k];
+            }
+        }
+        outFile << ";\n";
+    }
+    outFile << "\nendmodule\n";
+
+    outFile.close();
+
+    std::cout << endl << "Verilog module '" << functionName
+              << "' has been successfully generated and and saved to " << outputFileName << endl;
+
+    return true;
+}
@@ -17,8 +17,18 @@ public:
         int numVariables,
         const std::string& outputFileName
     );
-//helper function:
+    // one output wire per function (F0, F1, ...); a product term used by several outputs is
+    // one AND wire the outputs share
+    static bool generateMultiOutputModule(
+        const std::string& functionName,
+        const std::vector<std::string>& outputFunctions,
+        int numVariables,
+        const std::string& outputFileName
+    );
+//helper functions:
     static std::string convertToVerilogSyntax(const std::string& booleanFunction);
+
+    static std::string variableName(int index, int numVariables);
 };
 
 #endif // VERILOGCONVERTER_H
\ No newline at end of file
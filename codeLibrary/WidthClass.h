@@ -0,0 +1,115 @@
+//
+// Width classes: the variable count rounded up to 8, 16, 32 or 64 so the engines can be
+// instantiated with fixed-size cubes and group tables.
+//
+
+#ifndef QM_DD1_WIDTHCLASS_H
+#define QM_DD1_WIDTHCLASS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "Cube.h"
+
+// the smallest unsigned word with Width bits
+template <int Width> struct WidthWord;
+template <> struct WidthWord<8> { using type = uint8_t; };
+template <> struct WidthWord<16> { using type = uint16_t; };
+template <> struct WidthWord<32> { using type = uint32_t; };
+template <> struct WidthWord<64> { using type = uint64_t; };
+
+// Cube with words of the width class: 2 bytes for up to 8 variables instead of 16, so more of
+// a pass fits in cache. Same layout rules as Cube (mask bit set = fixed variable).
+template <int Width>
+struct FixedCube {
+    using Word = typename WidthWord<Width>::type;
+    Word mask = 0;
+    Word value = 0;
+
+    static FixedCube from(const Cube& c) {
+        FixedCube f;
+        f.mask = (Word)c.mask;
+        f.value = (Word)c.value;
+        return f;
+    }
+    Cube toCube() const {
+        Cube c;
+        c.mask = mask;
+        c.value = value;
+        return c;
+    }
+    int countOnes() const { return popcount64(value); }
+
+    bool operator==(const FixedCube& other) const { return mask == other.mask && value == other.value; }
+    bool operator!=(const FixedCube& other) const { return !(*this == other); }
+};
+
+template <int Width>
+struct FixedCubeHash {
+    size_t operator()(const FixedCube<Width>& c) const { return CubeHash()(c.toCube()); }
+};
+
+namespace WidthClass {
+
+// 8, 16, 32 or 64
+inline int of(int nbVars) {
+    return (nbVars <= 8) ? 8 : (nbVars <= 16) ? 16 : (nbVars <= 32) ? 32 : 64;
+}
+
+// calls f(std::integral_constant<int, W>{}) with the width class of nbVars, so f can use
+// decltype(w)::value as a template argument
+template <typename F>
+decltype(auto) dispatch(int nbVars, F&& f) {
+    switch (of(nbVars)) {
+        case 8: return f(std::integral_constant<int, 8>{});
+        case 16: return f(std::integral_constant<int, 16>{});
+        case 32: return f(std::integral_constant<int, 32>{});
+        default: return f(std::integral_constant<int, 64>{});
+    }
+}
+
+constexpr size_t binomial(int n, int k) {
+    if (k < 0 || k > n) return 0;
+    size_t result = 1;
+    for (int i = 1; i <= k; ++i) result = result * (size_t)(n - k + i) / (size_t)i;
+    return result;
+}
+
+// most cubes a combining pass over Width variables can hold with g ones: a pass has one dash
+// count k, and C(Width, k) * C(Width - k, g) cubes have k dashes and g ones
+template <int Width>
+constexpr std::array<size_t, Width + 1> groupCapacity() {
+    std::array<size_t, Width + 1> capacity{};
+    for (int g = 0; g <= Width; ++g)
+        for (int k = 0; k + g <= Width; ++k) {
+            const size_t cubes = binomial(Width, k) * binomial(Width - k, g);
+            if (cubes > capacity[(size_t)g]) capacity[(size_t)g] = cubes;
+        }
+    return capacity;
+}
+
+// where group g starts in one flat array of all the groups
+template <int Width>
+constexpr std::array<size_t, Width + 2> groupOffsets() {
+    constexpr std::array<size_t, Width + 1> capacity = groupCapacity<Width>();
+    std::array<size_t, Width + 2> offsets{};
+    for (int g = 0; g <= Width; ++g) offsets[(size_t)g + 1] = offsets[(size_t)g] + capacity[(size_t)g];
+    return offsets;
+}
+
+// most cubes in one pass: C(Width, k) * 2^(Width - k) for the worst dash count k
+template <int Width>
+constexpr size_t passCapacity() {
+    size_t most = 0;
+    for (int k = 0; k <= Width; ++k) {
+        const size_t cubes = binomial(Width, k) << (Width - k);
+        if (cubes > most) most = cubes;
+    }
+    return most;
+}
+
+} // namespace WidthClass
+
+#endif //QM_DD1_WIDTHCLASS_H
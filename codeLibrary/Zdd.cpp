@@ -0,0 +1,247 @@
+//
+// Implicit prime generation: a BDD of the on-set + don't cares, its prime implicants as a ZDD.
+//
+
+#include "Zdd.h"
+
+#include "Profile.h"
+
+namespace {
+
+const uint32_t kEmpty = 0;  // BDD: false, ZDD: the empty set
+const uint32_t kBase = 1;   // BDD: true, ZDD: the set holding only the empty cube
+const uint32_t kTerminalVar = 0xffffffffu; // terminals come after every variable
+
+struct Node {
+    uint32_t var;
+    uint32_t lo;
+    uint32_t hi;
+};
+
+// Hash-consed nodes of one diagram kind. The BDD and the ZDD each get their own table because
+// the same (var, lo, hi) reduces differently: a BDD node is skipped when lo == hi, a ZDD node
+// when hi is the empty set.
+class NodeTable {
+public:
+    NodeTable() : slots(1024, kEmpty) {
+        nodes.push_back({kTerminalVar, kEmpty, kEmpty});
+        nodes.push_back({kTerminalVar, kBase, kBase});
+    }
+
+    const Node& operator[](uint32_t id) const { return nodes[id]; }
+    size_t size() const { return nodes.size(); }
+
+    uint32_t bddNode(uint32_t var, uint32_t lo, uint32_t hi) { return lo == hi ? lo : find(var, lo, hi); }
+    uint32_t zddNode(uint32_t var, uint32_t lo, uint32_t hi) { return hi == kEmpty ? lo : find(var, lo, hi); }
+
+private:
+    std::vector<Node> nodes;
+    std::vector<uint32_t> slots; // open addressing, kEmpty = free (node 0 is never stored)
+
+    static size_t hashOf(uint32_t var, uint32_t lo, uint32_t hi) {
+        uint64_t h = ((uint64_t)lo << 32 | hi) * 0x9e3779b97f4a7c15ULL;
+        return (size_t)((h ^ (h >> 29)) + var * 0xbf58476d1ce4e5b9ULL);
+    }
+
+    uint32_t find(uint32_t var, uint32_t lo, uint32_t hi) {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hashOf(var, lo, hi) & mask;; i = (i + 1) & mask) {
+            uint32_t id = slots[i];
+            if (id == kEmpty) break;
+            const Node& node = nodes[id];
+            if (node.var == var && node.lo == lo && node.hi == hi) return id;
+        }
+        uint32_t id = (uint32_t)nodes.size();
+        nodes.push_back({var, lo, hi});
+        if (nodes.size() * 2 > slots.size()) rehash(slots.size() * 2);
+        else insert(id);
+        return id;
+    }
+
+    void insert(uint32_t id) {
+        size_t mask = slots.size() - 1;
+        const Node& node = nodes[id];
+        size_t i = hashOf(node.var, node.lo, node.hi) & mask;
+        while (slots[i] != kEmpty) i = (i + 1) & mask;
+        slots[i] = id;
+    }
+
+    void rehash(size_t size) {
+        slots.assign(size, kEmpty);
+        for (uint32_t id = 2; id < nodes.size(); ++id) insert(id);
+    }
+};
+
+// Memo of a binary operation on node ids. Lossy (a result overwrites whatever shared its slot, a
+// miss only costs a recomputation) and grown with the diagrams, so it stays a fixed fraction of
+// their size instead of keeping every pair ever seen.
+class OperationCache {
+public:
+    OperationCache() : entries(1 << 12) {}
+
+    bool find(uint32_t a, uint32_t b, uint32_t& result) const {
+        const Entry& entry = entries[slot(a, b)];
+        if (entry.a != a || entry.b != b) return false;
+        result = entry.result;
+        return true;
+    }
+    void store(uint32_t a, uint32_t b, uint32_t result) { entries[slot(a, b)] = {a, b, result}; }
+
+    // called with the current node count; doubling drops the old entries
+    void fit(size_t nodes) {
+        if (nodes <= entries.size()) return;
+        size_t size = entries.size();
+        while (size < nodes) size *= 2;
+        entries.assign(size, Entry());
+    }
+
+private:
+    struct Entry {
+        uint32_t a = kEmpty; // never a key, the terminal cases return before the cache
+        uint32_t b = kEmpty;
+        uint32_t result = kEmpty;
+    };
+    std::vector<Entry> entries;
+
+    size_t slot(uint32_t a, uint32_t b) const {
+        uint64_t h = ((uint64_t)a << 32 | b) * 0x9e3779b97f4a7c15ULL;
+        return (size_t)(h >> 32) & (entries.size() - 1);
+    }
+};
+
+// BDD variable k is pattern position k (bit n-1-k of a term); the ZDD has two variables per BDD
+// variable, 2k for the literal x_k and 2k+1 for x_k', so a cube is the set of its literals.
+class PrimeBuilder {
+public:
+    explicit PrimeBuilder(int nbVars) : n(nbVars) {}
+
+    NodeTable bdd;
+    NodeTable zdd;
+
+    // the BDD of a sorted, duplicate-free term list: at each level the terms with the bit clear
+    // come first (the higher bits are equal inside a call)
+    uint32_t build(const Term* begin, const Term* end, int level) {
+        if (begin == end) return kEmpty;
+        if (level == n) return kBase;
+        const Term bit = 1ULL << (n - 1 - level);
+        const Term* split = std::partition_point(begin, end, [&](Term t) { return (t & bit) == 0; });
+        uint32_t lo = build(begin, split, level + 1);
+        uint32_t hi = build(split, end, level + 1);
+        return bdd.bddNode((uint32_t)level, lo, hi);
+    }
+
+    uint32_t bddAnd(uint32_t a, uint32_t b) {
+        if (a == kEmpty || b == kEmpty) return kEmpty;
+        if (a == kBase) return b;
+        if (b == kBase || a == b) return a;
+        if (a > b) std::swap(a, b);
+        uint32_t result;
+        if (andCache.find(a, b, result)) return result;
+        const Node na = bdd[a], nb = bdd[b];
+        const uint32_t var = std::min(na.var, nb.var);
+        uint32_t lo = bddAnd(na.var == var ? na.lo : a, nb.var == var ? nb.lo : b);
+        uint32_t hi = bddAnd(na.var == var ? na.hi : a, nb.var == var ? nb.hi : b);
+        result = bdd.bddNode(var, lo, hi);
+        andCache.fit(bdd.size());
+        andCache.store(a, b, result);
+        return result;
+    }
+
+    // the cubes of a that are not in b
+    uint32_t zddDiff(uint32_t a, uint32_t b) {
+        if (a == kEmpty || a == b) return kEmpty;
+        if (b == kEmpty) return a;
+        uint32_t result;
+        if (diffCache.find(a, b, result)) return result;
+        const Node na = zdd[a], nb = zdd[b];
+        if (na.var < nb.var) result = zdd.zddNode(na.var, zddDiff(na.lo, b), na.hi);
+        else if (na.var > nb.var) result = zddDiff(a, nb.lo);
+        else result = zdd.zddNode(na.var, zddDiff(na.lo, nb.lo), zddDiff(na.hi, nb.hi));
+        diffCache.fit(zdd.size());
+        diffCache.store(a, b, result);
+        return result;
+    }
+
+    uint32_t primes(uint32_t f) {
+        if (f == kEmpty) return kEmpty;
+        if (f == kBase) return kBase; // the tautology: one prime, the cube with no literal
+        auto cached = primeCache.find(f);
+        if (cached != primeCache.end()) return cached->second;
+        const Node node = bdd[f];
+        uint32_t both = primes(bddAnd(node.lo, node.hi)); // primes without the variable
+        uint32_t negative = zddDiff(primes(node.lo), both);
+        uint32_t positive = zddDiff(primes(node.hi), both);
+        uint32_t result = zdd.zddNode(2 * node.var, zdd.zddNode(2 * node.var + 1, both, negative), positive);
+        primeCache.emplace(f, result);
+        return result;
+    }
+
+    double count(uint32_t z) {
+        if (z == kEmpty) return 0;
+        if (z == kBase) return 1;
+        auto cached = countCache.find(z);
+        if (cached != countCache.end()) return cached->second;
+        double result = count(zdd[z].lo) + count(zdd[z].hi);
+        countCache.emplace(z, result);
+        return result;
+    }
+
+    // every cube of z, lo branch (literal absent) first
+    void materialize(uint32_t z, Cube cube, vector<Implicant>& out) {
+        if (z == kEmpty) return;
+        if (z == kBase) {
+            Implicant imp;
+            imp.cube = cube;
+            imp.isPureDontCare = false;
+            out.push_back(std::move(imp));
+            return;
+        }
+        const Node node = zdd[z];
+        materialize(node.lo, cube, out);
+        const uint64_t bit = 1ULL << (n - 1 - (int)(node.var / 2));
+        cube.mask |= bit;
+        if (node.var % 2 == 0) cube.value |= bit;
+        materialize(node.hi, cube, out);
+    }
+
+private:
+    int n;
+    OperationCache andCache;
+    OperationCache diffCache;
+    unordered_map<uint32_t, uint32_t> primeCache;
+    unordered_map<uint32_t, double> countCache;
+};
+
+} // namespace
+
+vector<Implicant> Zdd::primeImplicants(int n, const vector<Term>& minterms, const vector<Term>& dontCares, ZddStats* stats) {
+    QM_PROFILE_TIMER("Zdd::primeImplicants");
+    vector<Term> care(minterms);
+    care.insert(care.end(), dontCares.begin(), dontCares.end());
+    sort(care.begin(), care.end());
+    care.erase(unique(care.begin(), care.end()), care.end());
+    // a term listed as a minterm and a don't care is a minterm
+    vector<Term> on(minterms);
+    sort(on.begin(), on.end());
+    vector<Term> dc;
+    set_difference(care.begin(), care.end(), on.begin(), on.end(), back_inserter(dc));
+
+    PrimeBuilder builder(n);
+    const uint32_t all = builder.primes(builder.build(care.data(), care.data() + care.size(), 0));
+    // a prime of on + dc that lies in dc is also a prime of dc, so this drops exactly those
+    const uint32_t pureDontCare = builder.primes(builder.build(dc.data(), dc.data() + dc.size(), 0));
+    const uint32_t needed = builder.zddDiff(all, pureDontCare);
+
+    vector<Implicant> primes;
+    builder.materialize(needed, Cube(), primes);
+    QM_PROFILE_ADD("zdd.bddNodes", builder.bdd.size());
+    QM_PROFILE_ADD("zdd.zddNodes", builder.zdd.size());
+    QM_PROFILE_ADD("primes", primes.size());
+    if (stats != nullptr) {
+        stats->bddNodes = builder.bdd.size();
+        stats->zddNodes = builder.zdd.size();
+        stats->primes = builder.count(all);
+        stats->needed = primes.size();
+    }
+    return primes;
+}
@@ -0,0 +1,34 @@
+//
+// Implicit prime generation: a BDD of the on-set + don't cares, its prime implicants as a ZDD.
+//
+
+#ifndef QM_DD1_ZDD_H
+#define QM_DD1_ZDD_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Implicant.h"
+
+// sizes of the diagrams behind one run (for the verbose output / the profile)
+struct ZddStats {
+    size_t bddNodes = 0;   // on-set + don't cares, plus the conjunctions the recursion built
+    size_t zddNodes = 0;   // every prime set of the recursion
+    double primes = 0;     // primes of on-set + don't cares (counted on the ZDD, never listed)
+    size_t needed = 0;     // primes that cover at least one minterm, the ones materialized
+};
+
+class Zdd {
+public:
+    // Prime implicants of a single-output function, without any intermediate cube: the terms
+    // become a BDD (variable A on top) and the primes come from the Coudert-Madre recursion
+    //   Primes(f) = Primes(f0.f1) + x'.(Primes(f0) - Primes(f0.f1)) + x.(Primes(f1) - Primes(f0.f1))
+    // as a ZDD over the literals, so memory follows the diagrams, not the number of cubes.
+    // Primes that lie entirely in the don't cares (Primes(on+dc) & Primes(dc)) are removed
+    // on the ZDD too; only the rest becomes Implicants (cube only, `covered` is left empty: the
+    // chart is built from the cubes).
+    static std::vector<Implicant> primeImplicants(int n, const std::vector<Term>& minterms,
+                                                  const std::vector<Term>& dontCares, ZddStats* stats = nullptr);
+};
+
+#endif //QM_DD1_ZDD_H
@@ -6,24 +6,207 @@
 #include <bitset>
 #include <filesystem>
 #include <algorithm>
+#include <charconv>
 #include <limits>
 #include <unordered_set>
 #include <unordered_map>
 
+#include "BatchRunner.h"
 #include "FileManip.h"
 #include "Implicant.h"
+#include "Pla.h"
+#include "Profile.h"
+#include "Server.h"
+#include "ThreadPool.h"
 
 using namespace std;
-namespace fs = std::__fs::filesystem;
+namespace fs = std::filesystem;
 
 
+// the whole of text as a decimal number ("4x", "abc" and "" are not)
+template <typename T>
+static bool parseNumber(const string& text, T& value) {
+    const auto parsed = from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && parsed.ec == errc() && parsed.ptr == text.data() + text.size();
+}
+
+// the profile covers the whole run (every file of a batch, every test of the interactive loop)
+static void writeProfile(const string& path) {
+#ifdef QM_PROFILE
+    if (!path.empty() && !Profile::writeJson(path))
+        cerr << "Error: could not write the profile to " << path << "\n";
+#else
+    (void)path;
+#endif
+}
+
+// --pla: the cubes go straight to the minimizer (see Pla.h), the first solution comes back as a PLA
+static int runPla(const string& inputPath, const string& outputPath, const RunOptions& options) {
+    PlaFunction function;
+    string error;
+    if (!Pla::load(inputPath, function, error)) {
+        cerr << error << "\n";
+        return 1;
+    }
+    ThreadPool pool(options.threads);
+    MinimizationResult result = Pla::minimize(function, options, &pool);
+    if (!result.verifyError.empty()) return 1;
+    // with the check on, the PLA is made in memory first and read back before it goes out
+    ostringstream text;
+    if (options.verify) {
+        Pla::write(text, function, result);
+        if (!Pla::checkWritten(function, text.str(), error)) {
+            cerr << error << "\n";
+            return 1;
+        }
+    }
+    auto emit = [&](ostream& out) { return options.verify ? bool(out << text.str()) : Pla::write(out, function, result); };
+    if (outputPath.empty()) return emit(cout) ? 0 : 1;
+    ofstream out(outputPath, ios::binary);
+    if (!out || !emit(out)) {
+        cerr << "Error: could not write " << outputPath << "\n";
+        return 1;
+    }
+    return 0;
+}
+
 // the main (wow)
-int main() {
+// options: --threads N          size of the thread pool used for prime generation (default: all cores)
+//          --cover bnb|petrick|ptree   solver for the non-essential PIs (default: bnb, petrick is the
+//                                 reference, ptree the same product as a parallel tree); implies
+//                                 --engine exact unless another engine is given. Both Petrick modes
+//                                 list every minimum cover, so they only suit small cyclic cores
+//                                 (with --reduce); a chart with a huge number of minimum covers
+//                                 runs for minutes where bnb lists a part of them
+//          --petrick-memory MB    ceiling of the ptree expressions, bnb takes over past it (default: 1024)
+//          --reduce               dominance reduction of the PI chart before the solver (faster, one cover per cost)
+//          --max-solutions N      minimum covers listed, a note counts the others (default: 100, 0 = all)
+//          --no-verify            skip the check of every solution against the function
+//          --engine auto|exact|heuristic|zdd   exact QM or the Espresso-style heuristic (default: auto, by
+//                                 size); zdd is exact QM with the primes generated on decision diagrams
+//          --batch DIR|LIST       minimize every file of a directory / list file without prompts
+//          --out DIR              where --batch writes its results (default: batchResults)
+//          --serve SOCKET|-       answer framed requests on a Unix socket (or stdin / stdout) until stopped
+//          --pla FILE             minimize a Berkeley PLA (espresso format) and write the result as a PLA
+//          --pla-out FILE         where --pla writes (default: stdout)
+//          --cache DIR            keep results on disk and reuse them for functions seen before
+//          --profile FILE         write the run's counters and timers as JSON (builds with -DQM_PROFILE)
+int main(int argc, char* argv[]) {
+    RunOptions options;
+    string batchInput;
+    string batchOutput = "batchResults";
+    string profilePath;
+    string serveOn;
+    string plaInput;
+    string plaOutput;
+    bool coverGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], options.threads) || options.threads < 0) {
+                cerr << "Error: --threads expects a number >= 0.\n";
+                return 1;
+            }
+        } else if (arg == "--cover" && i + 1 < argc) {
+            coverGiven = true;
+            string mode = argv[++i];
+            if (mode == "bnb") options.coverMode = CoverMode::BranchAndBound;
+            else if (mode == "petrick") options.coverMode = CoverMode::Petrick;
+            else if (mode == "ptree") options.coverMode = CoverMode::PetrickTree;
+            else {
+                cerr << "Error: --cover expects bnb, petrick or ptree.\n";
+                return 1;
+            }
+        } else if (arg == "--petrick-memory" && i + 1 < argc) {
+            int megabytes = 0;
+            if (!parseNumber(argv[++i], megabytes) || megabytes < 1) {
+                cerr << "Error: --petrick-memory expects a number of MB >= 1.\n";
+                return 1;
+            }
+            options.petrickMemoryMB = (size_t)megabytes;
+        } else if (arg == "--engine" && i + 1 < argc) {
+            string engine = argv[++i];
+            if (engine == "auto") options.engine = Engine::Auto;
+            else if (engine == "exact") options.engine = Engine::Exact;
+            else if (engine == "heuristic") options.engine = Engine::Heuristic;
+            else if (engine == "zdd") options.engine = Engine::Zdd;
+            else {
+                cerr << "Error: --engine expects auto, exact, heuristic or zdd.\n";
+                return 1;
+            }
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchInput = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serveOn = argv[++i];
+        } else if (arg == "--pla" && i + 1 < argc) {
+            plaInput = argv[++i];
+        } else if (arg == "--pla-out" && i + 1 < argc) {
+            plaOutput = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            batchOutput = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            options.cacheDir = argv[++i];
+            std::error_code ec;
+            fs::create_directories(options.cacheDir, ec);
+            if (ec) {
+                cerr << "Error: could not create " << options.cacheDir << ": " << ec.message() << "\n";
+                return 1;
+            }
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+            if (!QM_PROFILE_ENABLED) {
+                cerr << "Error: --profile needs a build with -DQM_PROFILE (the counters are compiled out otherwise).\n";
+                return 1;
+            }
+        } else if (arg == "--max-solutions" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], options.maxSolutions)) {
+                cerr << "Error: --max-solutions expects a number >= 0.\n";
+                return 1;
+            }
+        } else if (arg == "--reduce") {
+            options.reduceChart = true;
+        } else if (arg == "--no-verify") {
+            options.verify = false;
+        } else {
+            cerr << "Unknown option: " << arg << "\n";
+            cerr << "Usage: " << argv[0] << " [--threads N] [--cover bnb|petrick|ptree] [--petrick-memory MB] [--max-solutions N] [--reduce] [--no-verify] [--engine auto|exact|heuristic|zdd] [--cache DIR] [--profile FILE] [--batch DIR|LIST [--out DIR]] [--serve SOCKET|-] [--pla FILE [--pla-out FILE]]\n";
+            return 1;
+        }
+    }
+
+    // the cover solvers only run in the exact engines: asking for one picks exact over auto
+    if (coverGiven && options.engine == Engine::Auto) options.engine = Engine::Exact;
+    if (coverGiven && options.engine == Engine::Heuristic) cerr << "Note: --cover has no effect with --engine heuristic.\n";
+
+    // server mode: requests come over a socket / stdin, no prompts either
+    if (!serveOn.empty()) {
+        int status = Server::run(serveOn, options);
+        writeProfile(profilePath);
+        return status;
+    }
+
+    // PLA mode: one espresso-format file in, its minimized cover out as a PLA
+    if (!plaInput.empty()) {
+        int status = runPla(plaInput, plaOutput, options);
+        writeProfile(profilePath);
+        return status;
+    }
+
+    // batch mode: no prompts at all
+    if (!batchInput.empty()) {
+        int status = BatchRunner::run(batchInput, batchOutput, options);
+        writeProfile(profilePath);
+        return status;
+    }
+
     int n=1;
+    int status = 0; // non-zero once a test failed (file not found, cover failed its check)
     while (n==1) {
-        FileManip::doQMmin();
+        if (FileManip::doQMmin(options) != 0) status = 1;
         std::cout << endl << "Would you like to test another ? Input 1 for yes. ";
         std::cin >> n;
     }
+    writeProfile(profilePath);
 cout << endl << "Terminating program.";
+    return status;
 }
@@ -0,0 +1,55 @@
+#!/bin/bash
+# Runs the testcases that pin a behaviour (11 and up, see README) and prints ok / FAIL for each
+# check; exits 1 when one failed.
+# usage: testcases/check.sh path/to/qm
+qm=$(realpath "${1:?usage: $0 path/to/qm}")
+cd "$(dirname "$0")" || exit 1
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failed=0
+
+# cover FILE [options]: "<solutions> <cubes>" of FILE as --batch minimizes it, "-" when it fails
+# or takes more than a minute
+cover() {
+    local file=$1
+    shift
+    echo "$PWD/$file" > "$work/list"
+    rm -rf "$work/out"
+    timeout 60 "$qm" "$@" --batch "$work/list" --out "$work/out" > /dev/null 2>&1 || { echo -; return; }
+    awk 'NR == 2 { print $5, $6 }' "$work/out/summary.txt"
+}
+
+# expect WHAT GOT WANTED
+expect() {
+    if [ "$2" != - ] && [ "$2" = "$3" ]; then
+        echo "ok    $1: $2"
+    else
+        echo "FAIL  $1: got $2, expected $3"
+        failed=1
+    fi
+}
+
+# auto runs a small space exact, whatever its density
+expect "test11 auto" "$(cover test11.txt | cut -d' ' -f2)" 40
+# three outputs sharing product terms / the last output without its don't care line
+expect "test12 multi-output" "$(cover test12.txt)" "1 4"
+expect "test13 no last don't care line" "$(cover test13.txt)" "1 4"
+
+# every exact engine and cover solver lists the same minimum covers
+want=$(cover test14.txt --engine exact)
+expect "test14 exact" "$want" "84 15"
+for options in "--engine zdd" "--cover petrick" "--cover ptree"; do
+    expect "test14 $options" "$(cover test14.txt $options)" "$want"
+done
+
+# a PLA minimized, written and read back (qm checks what it wrote against the input), then
+# minimized again: nothing left to take out
+"$qm" --pla test15.pla --pla-out "$work/once.pla" 2> /dev/null
+"$qm" --pla "$work/once.pla" --pla-out "$work/twice.pla" 2> /dev/null
+expect "test15.pla" "$(grep -cs '^[01-]' "$work/once.pla")" 8
+expect "test15.pla read back" "$(grep -cs '^[01-]' "$work/twice.pla")" 8
+
+# a dense 10-variable chart: auto gives up on the exact cover search and runs the heuristic
+expect "test16 auto falls back" "$(cover test16.txt)" "1 163"
+
+exit $failed